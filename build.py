@@ -17,7 +17,10 @@ PYTHON_SCRIPTS = [
     'dispatcher.py',
     'leader.py',
     'partitioner.py',
-    'partition_tree.py'
+    'partition_tree.py',
+    'resident_solver.py',
+    'task_buffer.py',
+    'task_delta.py'
 ]
 
 PARTITIONER_BINARY_SRC = PARTITIONER_BUILD_DIR / 'z3'
@@ -128,7 +128,15 @@ def build_mpi_command(config, temp_folder, rankfile_path):
         '--time-limit', str(config['timeout_seconds']),
         '--solver', solver_bin,
         '--available-cores-list', json.dumps(config['worker_node_cores']),
-        '--partitioner', partitioner_bin
+        '--partitioner', partitioner_bin,
+        '--delta-tasks', str(int(config.get('delta_tasks', False))),
+        '--task-buffer-mb', str(config.get('task_buffer_mb', 0)),
+        '--resident-workers', str(int(config.get('resident_workers', False))),
+        '--partitioner-restarts', str(config.get('partitioner_restarts', 0)),
+        '--subtree-donation', str(int(config.get('subtree_donation', False))),
+        '--partition-cache', config.get('partition_cache', ''),
+        # joined with '=', the arguments start with a dash
+        f"--resident-solver-args={config.get('resident_solver_args', '-in')}"
     ]
     return shlex.join(cmd)
 
@@ -82,25 +82,41 @@ class ControlMessage:
     class C2P(Enum):
         unsat_node = 0
         terminate_node = 1
+        # write the subtree of a node to a file, for the coordinator it is donated to
+        export_subtree = 2
         
         def is_unsat_node(self):
             return self == ControlMessage.C2P.unsat_node
         
         def is_terminate_node(self):
             return self == ControlMessage.C2P.terminate_node
+        
+        def is_export_subtree(self):
+            return self == ControlMessage.C2P.export_subtree
     
     # Partitioner To Coordinator
     class P2C(Enum):
         debug_info = 0
         new_unknown_node = 1
         new_unsat_node = 2
+        # a model was found in the box of a node
         sat = 3
         unsat = 4
         unknown = 5
+        # the task of a new node is in the shared task buffer
+        task_buffer = 6
+        # the subtree of a node is exported
+        subtree_exported = 7
         
         def is_debug_info(self):
             return self == ControlMessage.P2C.debug_info
         
+        def is_task_buffer(self):
+            return self == ControlMessage.P2C.task_buffer
+        
+        def is_subtree_exported(self):
+            return self == ControlMessage.P2C.subtree_exported
+        
         def is_new_unknown_node(self):
             return self == ControlMessage.P2C.new_unknown_node
         
@@ -15,6 +15,9 @@ from partition_tree import ParallelNode, ParallelTree
 from partition_tree import NodeStatus, NodeReason
 from control_message import TerminateMessage, ControlMessage
 from partitioner import Partitioner
+from task_buffer import TaskBuffer
+from task_delta import DeltaTaskLoader
+from resident_solver import ResidentSolver
 
 def raise_error(error_info):
     logging.error(error_info)
@@ -71,6 +74,14 @@ class Coordinator:
         self.original_process = None
         self.partitioner = None
         self.tree = None
+        self.resident_solvers = []
+        self.task_buffer = None
+        self.delta_loader = DeltaTaskLoader()
+        self.num_partitioner_restarts = 0
+        # node pid -> True once the partitioner exported its subtree
+        self.subtree_exports = {}
+        # subtree of the received node, imported by the partitioner
+        self.import_subtree_path = None
         
         logging.debug(f'rank: {self.rank}, leader_rank: {self.leader_rank}')
         logging.debug(f'get-model-flag: {self.get_model_flag}')
@@ -113,6 +124,20 @@ class Coordinator:
                                 help='partitioner path')
         coordinator_args.add_argument('--available-cores-list', type=str, required=True, 
                                 help='available cores list')
+        coordinator_args.add_argument('--delta-tasks', type=int, default=0,
+                                help='partitioner writes tasks as deltas of a shared task base')
+        coordinator_args.add_argument('--task-buffer-mb', type=int, default=0,
+                                help='size of the shared memory buffer the tasks are passed through, 0 means task files')
+        coordinator_args.add_argument('--resident-workers', type=int, default=0,
+                                help='solve tasks with long-lived backend solvers fed by resident workers')
+        coordinator_args.add_argument('--resident-solver-args', type=str, default='-in',
+                                help='arguments that make the solver read SMT-LIB from standard input')
+        coordinator_args.add_argument('--partitioner-restarts', type=int, default=0,
+                                help='times a crashed partitioner is restarted from the journal of its tree, 0 means no journal')
+        coordinator_args.add_argument('--subtree-donation', type=int, default=0,
+                                help='a donated node comes with its partition subtree, which the receiving partitioner goes on with')
+        coordinator_args.add_argument('--partition-cache', type=str, default='',
+                                help='directory where partitioners share their preprocessed goals and root bounds, empty means no cache')
         
         cmd_args = arg_parser.parse_args()
         self.output_folder_path: str = cmd_args.output_dir
@@ -123,6 +148,15 @@ class Coordinator:
         
         self.solver_path: str = cmd_args.solver
         self.partitioner_path: str = cmd_args.partitioner
+        self.resident_workers: bool = bool(cmd_args.resident_workers)
+        self.resident_solver_args: list = cmd_args.resident_solver_args.split()
+        self.partitioner_restarts: int = cmd_args.partitioner_restarts
+        self.subtree_donation: bool = bool(cmd_args.subtree_donation)
+        self.partition_cache: str = cmd_args.partition_cache
+        # resident workers read the delta tasks
+        self.delta_tasks: bool = bool(cmd_args.delta_tasks) or self.resident_workers
+        # delta tasks refer to the task base by file name
+        self.task_buffer_mb: int = 0 if self.delta_tasks else cmd_args.task_buffer_mb
         available_cores_list: list = json.loads(cmd_args.available_cores_list)
         
         self.available_cores: int = available_cores_list[self.rank]
@@ -169,18 +203,30 @@ class Coordinator:
                 # remains = ' '.join(words[1: ])
                 # logging.debug(f'partitioner-debug-info {remains}')
                 pass
+            elif op.is_task_buffer():
+                self.task_buffer.receive_task(words[1], int(words[2]), int(words[3]))
+            elif op.is_subtree_exported():
+                self.subtree_exports[int(words[1])] = True
+            elif op.is_sat():
+                # a model was found in the box of the node,
+                # the partitioner answers sat (and displays the model) next
+                logging.info(f'node-{words[1]} solved sat by the partitioner')
             elif op.is_new_node():
                 pid = int(words[1])
                 ppid = int(words[2])
                 node = self.tree.make_node(pid, ppid)
+                if len(words) > 3:
+                    logging.debug(f'node-{pid} predicted difficulty {words[3]}')
                 if op.is_new_unsat_node():
                     self.tree.node_solved_unsat(node,
                             NodeReason.partitioner)
+                    self.release_ended_tasks(node)
                     if self.is_done():
                         return
                 elif node.parent != None and node.parent.status.is_unsat():
                     self.tree.node_solved_unsat(node,
                             NodeReason.ancester)
+                    self.release_ended_tasks(node)
                 else:
                     self.tree.waitings.append(node)
                 # if pid % 10 == 0:
@@ -223,8 +269,13 @@ class Coordinator:
             # receive_done: break
             if not self.partitioner.is_process_done():
                 break
+        if self.partitioner.is_receive_done() and self.partitioner.crashed \
+                and self.num_partitioner_restarts < self.partitioner_restarts:
+            self.restart_partitioner()
     
     def check_subprocess_status(self, p: subprocess.Popen):
+        if isinstance(p, ResidentSolver):
+            return self.check_resident_solver_status(p)
         rc = p.poll()
         if rc == None:
             return NodeStatus.solving
@@ -239,7 +290,18 @@ class Coordinator:
             # raise_error(f'return code = {rc}\nstdout: {out_data}\nstderr: {err_data}')
 
         assert(rc == 0)
-        
+        return self.parse_solver_output(out_data, f'return code = {rc}', f'stderr: {err_data}')
+    
+    def check_resident_solver_status(self, p: ResidentSolver):
+        ret = p.receive_result()
+        if ret == None:
+            return NodeStatus.solving
+        succeed, out_data = ret
+        if not succeed:
+            return NodeStatus.error
+        return self.parse_solver_output(out_data, f'resident task = {p.task_id}', '')
+    
+    def parse_solver_output(self, out_data: str, proc_info: str, err_info: str):
         if not self.get_model_flag:
             sta: str = out_data.strip('\n').strip(' ')
         else:
@@ -255,9 +317,9 @@ class Coordinator:
             return NodeStatus.unsat
         else:
             logging.error('subprocess error')
-            logging.error(f'return code = {rc}')
+            logging.error(proc_info)
             logging.error(f'stdout: {out_data}')
-            logging.error(f'stderr: {err_data}')
+            logging.error(err_info)
             return NodeStatus.error
             # raise_error(f'subprocess error state: {sta}')
     
@@ -270,12 +332,42 @@ class Coordinator:
         # logging.debug(f'succeed')
         self.partitioner.send_message(msg)
     
+    # close the memfd of the task of a node that is not solved anymore,
+    # the task of the split node is kept until it is sent to the target coordinator
+    def release_node_task(self, node: ParallelNode):
+        if self.task_buffer == None or node is self.split_node:
+            return
+        self.task_buffer.release_task(f'{node.pid}')
+    
+    # release the tasks of node and of the nodes that ended with it:
+    # the subtree of an unsat node and its ancestors that became unsat by their children
+    def release_ended_tasks(self, node: ParallelNode):
+        if self.task_buffer == None:
+            return
+        if not node.status.is_unsat():
+            self.release_node_task(node)
+            return
+        todo = [node]
+        while len(todo) > 0:
+            n: ParallelNode = todo.pop()
+            self.release_node_task(n)
+            todo.extend(n.children)
+        ancestor = node.parent
+        while ancestor != None and ancestor.status.is_unsat():
+            self.release_node_task(ancestor)
+            ancestor = ancestor.parent
+    
     def sync_ended_to_partitioner(self, node: ParallelNode, status: NodeStatus):
+        self.release_ended_tasks(node)
         if status.is_unsat():
             sta_val = ControlMessage.C2P.unsat_node.value
         else:
             sta_val = ControlMessage.C2P.terminate_node.value
         msg = f'{sta_val} {node.pid}'
+        # the partitioner trains its cost model with the solving time
+        solving_time = self.tree.get_node_solving_time(node)
+        if solving_time is not None:
+            msg += f' {solving_time:.3f}'
         self.send_partitioner_message(msg)
     
     def need_terminate(self, node: ParallelNode):
@@ -331,6 +423,7 @@ class Coordinator:
             self.terminate_node(node)
             return False
         node.assign_to = None
+        self.release_node_task(node)
         logging.info(f'solved: node-{node.id} is {sta}')
         self.tree.node_solved(node, sta)
         self.log_tree_infos()
@@ -340,16 +433,58 @@ class Coordinator:
         self.sync_ended_to_partitioner(node, NodeStatus.unsat)
         return False
     
-    def solve_task(self, task_tag: str):
+    def get_delta_path(self, task_tag: str):
+        return f'{self.solving_folder_path}/task-{task_tag}.delta'
+    
+    # in delta mode the partitioner writes task-<id>.delta,
+    # the SMT-LIB task is spliced from it and the (parsed once) task base on demand
+    def materialize_task(self, task_tag: str):
+        if self.task_buffer != None:
+            instance_path = self.task_buffer.get_task_path(task_tag)
+            if instance_path != None:
+                return instance_path
         instance_path = f'{self.solving_folder_path}/task-{task_tag}.smt2'
+        if self.delta_tasks and not os.path.exists(instance_path):
+            task = self.delta_loader.materialize(self.get_delta_path(task_tag))
+            with open(instance_path, 'w', encoding='latin-1', newline='') as file:
+                file.write(task)
+        return instance_path
+    
+    # an idle resident solver, started on demand, one per available core
+    def get_resident_solver(self):
+        for rs in self.resident_solvers:
+            if rs.is_idle():
+                return rs
+        assert(len(self.resident_solvers) < self.available_cores)
+        rs = ResidentSolver([self.partitioner_path, f'-worker:{self.solving_folder_path}'],
+                            [self.solver_path] + self.resident_solver_args)
+        self.resident_solvers.append(rs)
+        return rs
+    
+    def stop_resident_solvers(self):
+        for rs in self.resident_solvers:
+            rs.stop()
+        self.resident_solvers = []
+    
+    def solve_task(self, task_tag: str):
+        # the original task is not a delta task
+        if self.resident_workers and task_tag != 'root':
+            rs = self.get_resident_solver()
+            rs.solve(task_tag)
+            return rs
+        instance_path = self.materialize_task(task_tag)
         cmd =  [self.solver_path,
                 instance_path,
             ]
         # logging.debug('exec-command {}'.format(' '.join(cmd)))
+        pass_fds = ()
+        if self.task_buffer != None:
+            pass_fds = self.task_buffer.get_task_fds(task_tag)
         p = subprocess.Popen(
                 cmd,
                 stdout=subprocess.PIPE,
                 stderr=subprocess.PIPE,
+                pass_fds=pass_fds,
                 text=True
             )
         return p
@@ -395,8 +530,8 @@ class Coordinator:
                 break
             self.solve_node(node)
     
-    # run the partitioner
-    def run_partitioner(self):
+    # run the partitioner, restore: rebuild the tree of the previous partitioner from its journal
+    def run_partitioner(self, restore: bool = False):
         if self.rank != self.isolated_rank:
             parti_seed = 0
         else:
@@ -408,8 +543,26 @@ class Coordinator:
                 f'-outputdir:{self.solving_folder_path}',
                 f'-partimrt:{max(self.available_cores, self.num_dist_coords)}',
                 f'-partiseed:{parti_seed}',
-                f'-getmodelflag:{int(self.get_model_flag)}'
+                f'-getmodelflag:{int(self.get_model_flag)}',
+                f'-partidelta:{int(self.delta_tasks)}'
             ]
+        if self.task_buffer_mb > 0:
+            # a restarted partitioner goes on with the buffer of the previous one
+            if self.task_buffer == None:
+                self.task_buffer = TaskBuffer(f'ariparti-{os.getpid()}-{self.solving_round}',
+                                              self.task_buffer_mb * 1024 * 1024)
+            cmd.append(f'-partibuffer:{self.task_buffer.name}')
+        if self.partitioner_restarts > 0:
+            journal_path = f'{self.solving_folder_path}/partitioner.journal'
+            cmd.append(f'-partisnapshot:{journal_path}')
+            if restore:
+                cmd.append(f'-partirestore:{journal_path}')
+        if self.partition_cache != '':
+            os.makedirs(self.partition_cache, exist_ok=True)
+            cmd.append(f'-particache:{self.partition_cache}')
+        # the journal of a restored partitioner already has the imported splits
+        if self.import_subtree_path != None and not restore:
+            cmd.append(f'-partiimport:{self.import_subtree_path}')
         logging.debug(f'exec-command {" ".join(cmd)}')
         p = subprocess.Popen(
                 cmd,
@@ -420,6 +573,15 @@ class Coordinator:
             )
         self.partitioner = Partitioner(p)
     
+    def restart_partitioner(self):
+        self.num_partitioner_restarts += 1
+        logging.info(f'restart partitioner ({self.num_partitioner_restarts}/{self.partitioner_restarts})')
+        self.run_partitioner(restore=True)
+        # the journal may miss the last results, the partitioner ignores the ones it knows
+        for node in self.tree.nodes:
+            if node.status.is_ended():
+                self.sync_ended_to_partitioner(node, node.status)
+    
     def terminate_partitioner(self):
         if self.partitioner.check_running():
             self.partitioner.p.terminate()
@@ -432,6 +594,7 @@ class Coordinator:
         self.solving_start_time = time.time()
         self.tree = ParallelTree(self.solving_start_time)
         self.split_node = None
+        self.num_partitioner_restarts = 0
         self.run_partitioner()
 
     # coordinator [rank] solved the assigned node
@@ -535,9 +698,18 @@ class Coordinator:
         solving_folder_path = f'{self.coord_temp_folder_path}/tasks/round-{self.solving_round}'
         os.makedirs(solving_folder_path, exist_ok=True)
         instance_path = f'{solving_folder_path}/task-root.smt2'
-        instance_data = MPI.COMM_WORLD.recv(source=coord_rank, tag=2)
+        instance_data, delta_data, subtree_data = MPI.COMM_WORLD.recv(source=coord_rank, tag=2)
+        if delta_data != None:
+            # instance_data is the task base of the delta
+            loader = DeltaTaskLoader()
+            loader.set_base('task base', instance_data.decode('latin-1'))
+            instance_data = loader.splice(delta_data.decode('latin-1')).encode('latin-1')
         with open(instance_path, 'bw') as file:
             file.write(instance_data)
+        if subtree_data != None:
+            self.import_subtree_path = f'{solving_folder_path}/subtree.txt'
+            with open(self.import_subtree_path, 'bw') as file:
+                file.write(subtree_data)
     
     def process_assign_message(self):
         coord_rank = MPI.COMM_WORLD.recv(source=self.leader_rank, tag=2)
@@ -551,22 +723,69 @@ class Coordinator:
         MPI.COMM_WORLD.send(target_rank, 
                             dest=self.leader_rank, tag=2)
     
+    # the task of the split node is sent as it is written by the partitioner:
+    # a delta task with its task base, spliced by the target coordinator, or a full task
     def send_split_node_to_coordinator(self, target_rank):
-        instance_path = f'{self.solving_folder_path}/task-{self.split_node.pid}.smt2'
+        task_tag = f'{self.split_node.pid}'
+        delta_data = None
+        if self.delta_tasks:
+            delta_path = self.get_delta_path(task_tag)
+            with open(delta_path, 'br') as file:
+                delta_data = file.read()
+            base_name = DeltaTaskLoader.get_base_name(delta_data.decode('latin-1'))
+            instance_path = os.path.join(os.path.dirname(delta_path), base_name)
+        else:
+            instance_path = self.materialize_task(task_tag)
         logging.debug(f'split task path: {instance_path}')
         with open(instance_path, 'br') as file:
             instance_data = file.read()
-        MPI.COMM_WORLD.send(instance_data, 
+        subtree_data = self.collect_subtree_export(self.split_node)
+        MPI.COMM_WORLD.send((instance_data, delta_data, subtree_data), 
                             dest=target_rank, tag=2)
+        # the nodes sent by the pre-partitioning are still solved here
+        node = self.split_node
+        self.split_node = None
+        if node.status.is_ended():
+            self.release_node_task(node)
         
     def send_root_task_to_coordinator(self, target_rank):
         instance_path = f'{self.solving_folder_path}/task-root.smt2'
         logging.debug(f'split task path: {instance_path}')
         with open(instance_path, 'br') as file:
             instance_data = file.read()
-        MPI.COMM_WORLD.send(instance_data, 
+        MPI.COMM_WORLD.send((instance_data, None, None), 
                             dest=target_rank, tag=2)
     
+    def get_subtree_path(self, node: ParallelNode):
+        return f'{self.solving_folder_path}/subtree-{node.pid}.txt'
+    
+    # ask the partitioner for the subtree of a node to donate,
+    # before the node is reported unsat and its subtree is collected
+    def request_subtree_export(self, node: ParallelNode):
+        if not self.subtree_donation or node.pid in self.subtree_exports:
+            return
+        self.subtree_exports[node.pid] = False
+        sta_val = ControlMessage.C2P.export_subtree.value
+        self.send_partitioner_message(f'{sta_val} {node.pid} {self.get_subtree_path(node)}')
+    
+    # the exported subtree of a node, None if it is not ready in time
+    def collect_subtree_export(self, node: ParallelNode):
+        if not self.subtree_donation:
+            return None
+        self.request_subtree_export(node)
+        deadline = time.time() + 2.0
+        while not self.subtree_exports[node.pid]:
+            if self.partitioner.is_receive_done() or time.time() > deadline:
+                logging.debug(f'subtree of node-{node.pid} is not exported')
+                return None
+            self.receive_partitioner_messages()
+            time.sleep(0.01)
+        path = self.get_subtree_path(node)
+        if not os.path.exists(path):
+            return None
+        with open(path, 'br') as file:
+            return file.read()
+    
     def send_split_failed_to_leader(self, target_rank):
         MPI.COMM_WORLD.send(ControlMessage.C2L.split_failed,
                             dest=self.leader_rank, tag=1)
@@ -587,6 +806,7 @@ class Coordinator:
         logging.debug(f'split node: {node}')
         self.send_split_succeed_to_leader(target_rank)
         self.split_node = node
+        self.request_subtree_export(node)
         self.set_node_split(node, target_rank)
         
     def process_transfer_message(self):
@@ -605,6 +825,12 @@ class Coordinator:
             if node.assign_to != None:
                 node.assign_to.terminate()
                 node.assign_to = None
+        self.stop_resident_solvers()
+        if self.task_buffer != None:
+            self.task_buffer.close()
+            self.task_buffer = None
+        self.subtree_exports = {}
+        self.import_subtree_path = None
         self.tree = None
         # shutil.rmtree(self.solving_folder_path)
 
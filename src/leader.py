@@ -100,6 +100,20 @@ class Leader:
                                 help='partitioner path')
         coordinator_args.add_argument('--available-cores-list', type=str, required=True, 
                                 help='available cores list')
+        coordinator_args.add_argument('--delta-tasks', type=int, default=0,
+                                help='partitioner writes tasks as deltas of a shared task base')
+        coordinator_args.add_argument('--task-buffer-mb', type=int, default=0,
+                                help='size of the shared memory buffer the tasks are passed through, 0 means task files')
+        coordinator_args.add_argument('--resident-workers', type=int, default=0,
+                                help='solve tasks with long-lived backend solvers fed by resident workers')
+        coordinator_args.add_argument('--resident-solver-args', type=str, default='-in',
+                                help='arguments that make the solver read SMT-LIB from standard input')
+        coordinator_args.add_argument('--partitioner-restarts', type=int, default=0,
+                                help='times a crashed partitioner is restarted from the journal of its tree, 0 means no journal')
+        coordinator_args.add_argument('--subtree-donation', type=int, default=0,
+                                help='a donated node comes with its partition subtree, which the receiving partitioner goes on with')
+        coordinator_args.add_argument('--partition-cache', type=str, default='',
+                                help='directory where partitioners share their preprocessed goals and root bounds, empty means no cache')
         
         cmd_args = arg_parser.parse_args()
         self.temp_folder_path: str = cmd_args.temp_dir
@@ -45,6 +45,7 @@ class Partitioner:
     def __init__(self, p: subprocess.Popen):
         self.status = PartitionerStatus.running
         self.result = PartitionerResult.unsolved
+        self.crashed = False
         self.partial_line = ''
         self.buffer = None
         
@@ -89,6 +90,7 @@ class Partitioner:
         if rc != 0:
             out_data, err_data = self.p.communicate()
             logging.error(f'Partitioner Crashed! return code: {rc}')
+            self.crashed = True
             logging.error(f'output: {out_data}')
             logging.error(f'error: {err_data}')
             # assert(False)
@@ -42,6 +42,7 @@ def init_project_def():
     
     API_files = []
     add_exe('shell', ['portfolio'], exe_name='z3')
+    add_exe('partitioner_bench', ['portfolio'], path='bench', exe_name='partitioner-bench', install=False)
     add_js()
     return API_files
 
@@ -190,6 +190,7 @@ class smt_printer {
     bool             m_no_lets;
     bool             m_simplify_implies;
     expr*            m_top;
+    ast_smt_pp::term_cache* m_cache;
 
     bool is_bool(sort* s) {
         return
@@ -605,7 +606,10 @@ class smt_printer {
             visit_quantifier(to_quantifier(n));
             break;
         case AST_APP:
-            visit_app(to_app(n));
+            if (m_cache && m_qlists.empty() && m_cache->is_stable(n))
+                pp_cached(to_app(n));
+            else
+                visit_app(to_app(n));
             break;
         case AST_VAR:
             visit_var(to_var(n));
@@ -615,6 +619,19 @@ class smt_printer {
         }
     }
 
+    void pp_cached(app* n) {
+        ast_smt_pp::term_cache::entry & e = m_cache->get(n);
+        if (!e.m_printed) {
+            std::ostringstream buffer;
+            smt_printer p(buffer, m_manager, m_qlists, m_renaming, m_logic, m_no_lets, m_simplify_implies, m_indent, m_num_var_names, m_var_names);
+            p.set_cache(m_cache);
+            p.visit_app(n);
+            e.m_text = buffer.str();
+            e.m_printed = true;
+        }
+        m_out << e.m_text;
+    }
+
     void visit_expr(expr* n) {
         m_out << "(let ((";
         pp_id(n);
@@ -732,7 +749,9 @@ public:
         m_AUFLIRA("AUFLIRA"),
         // It's much easier to read those testcases with that.
         m_no_lets(true),
-        m_simplify_implies(simplify_implies)
+        m_simplify_implies(simplify_implies),
+        m_top(nullptr),
+        m_cache(nullptr)
     {
         m_basic_fid = m.get_basic_family_id();
         m_label_fid = m.mk_family_id("label");
@@ -743,6 +762,8 @@ public:
         m_fpa_fid   = m.mk_family_id("fpa");
     }
 
+    void set_cache(ast_smt_pp::term_cache* c) { m_cache = c; }
+
     void operator()(expr* n) {
         m_top = n;
         if (!m_no_lets) {
@@ -892,6 +913,71 @@ public:
 };
 
 
+// ---------------------------------------
+// ast_smt_pp::term_cache
+
+ast_smt_pp::term_cache::term_cache(ast_manager& m):
+    m(m),
+    m_pinned(m)
+{}
+
+ast_smt_pp::term_cache::~term_cache() {
+    for (auto const& kv : m_terms)
+        dealloc(kv.m_value);
+    for (auto const& kv : m_func_decls)
+        dealloc(kv.m_value);
+}
+
+ast_smt_pp::term_cache::entry& ast_smt_pp::term_cache::get(u_map<entry*>& map, ast* a) {
+    entry* e = nullptr;
+    if (!map.find(a->get_id(), e)) {
+        e = alloc(entry);
+        map.insert(a->get_id(), e);
+        m_pinned.push_back(a);
+    }
+    return *e;
+}
+
+bool ast_smt_pp::term_cache::is_stable(expr* e) const {
+    return is_app(e) && to_app(e)->get_num_args() > 0 && !m.is_bool(e);
+}
+
+// Same order as decl_collector::visit: the declarations of a term in the cache are the ones
+// of a walk of the term alone, the ones that were already collected are skipped by decls.
+void ast_smt_pp::term_cache::collect_decls(decl_collector& decls, expr* n, ast_mark& visited) {
+    m_todo.push_back(n);
+    while (!m_todo.empty()) {
+        n = m_todo.back();
+        m_todo.pop_back();
+        if (visited.is_marked(n))
+            continue;
+        visited.mark(n, true);
+        if (is_stable(n)) {
+            entry& e = get(n);
+            if (!e.m_collected) {
+                decl_collector dc(m);
+                dc.visit(n);
+                for (func_decl* d : dc.get_func_decls())
+                    e.m_decls.push_back(d);
+                for (func_decl* d : dc.get_rec_decls())
+                    e.m_decls.push_back(d);
+                for (sort* s : dc.get_sorts())
+                    e.m_decls.push_back(s);
+                e.m_collected = true;
+            }
+            for (ast* a : e.m_decls)
+                decls.visit(a);
+        }
+        else if (is_app(n)) {
+            for (expr* arg : *to_app(n))
+                m_todo.push_back(arg);
+            decls.visit(to_app(n)->get_decl());
+        }
+        else
+            decls.visit(n);
+    }
+}
+
 // ---------------------------------------
 // ast_smt_pp:
 
@@ -906,7 +992,8 @@ ast_smt_pp::ast_smt_pp(ast_manager& m):
     m_logic(),
     m_dt_fid(m.mk_family_id("datatype")),
     m_is_declared(&m_is_declared_default),
-    m_simplify_implies(true)
+    m_simplify_implies(true),
+    m_cache(nullptr)
 {}
 
 void ast_smt_pp::display_expr_smt2(std::ostream& strm, expr* n, unsigned indent, unsigned num_var_names, char const* const* var_names) {
@@ -947,15 +1034,28 @@ void ast_smt_pp::display_smt2(std::ostream& strm, expr* n) {
     ptr_vector<quantifier> ql;
     ast_manager& m = m_manager;
     decl_collector decls(m);
-    smt_renaming rn;
+    smt_renaming local_rn;
+    smt_renaming& rn = m_cache ? m_cache->m_renaming : local_rn;
 
-    for (expr* a : m_assumptions) {
-        decls.visit(a);
+    if (m_cache) {
+        ast_mark visited;
+        for (expr* a : m_assumptions) {
+            m_cache->collect_decls(decls, a, visited);
+        }
+        for (expr* a : m_assumptions_star) {
+            m_cache->collect_decls(decls, a, visited);
+        }
+        m_cache->collect_decls(decls, n, visited);
     }
-    for (expr* a : m_assumptions_star) {
-        decls.visit(a);
+    else {
+        for (expr* a : m_assumptions) {
+            decls.visit(a);
+        }
+        for (expr* a : m_assumptions_star) {
+            decls.visit(a);
+        }
+        decls.visit(n);
     }
-    decls.visit(n);
 
     if (m.is_proof(n)) {
         strm << "(";
@@ -993,7 +1093,21 @@ void ast_smt_pp::display_smt2(std::ostream& strm, expr* n) {
 
     for (unsigned i = 0; i < decls.get_num_decls(); ++i) {
         func_decl* d = decls.get_func_decls()[i];
-        if (!(*m_is_declared)(d)) {
+        if ((*m_is_declared)(d)) {
+            continue;
+        }
+        if (m_cache) {
+            term_cache::entry& e = m_cache->get(d);
+            if (!e.m_printed) {
+                std::ostringstream buffer;
+                smt_printer p(buffer, m, ql, rn, m_logic, true, true, m_simplify_implies, 0);
+                p(d);
+                e.m_text = buffer.str();
+                e.m_printed = true;
+            }
+            strm << e.m_text << "\n";
+        }
+        else {
             smt_printer p(strm, m, ql, rn, m_logic, true, true, m_simplify_implies, 0);
             p(d);
             strm << "\n";
@@ -1004,6 +1118,7 @@ void ast_smt_pp::display_smt2(std::ostream& strm, expr* n) {
 
     for (expr* a : m_assumptions) {
         smt_printer p(strm, m, ql, rn, m_logic, false, true, m_simplify_implies, 1);
+        p.set_cache(m_cache);
         strm << "(assert\n ";
         p(a);
         strm << ")\n";
@@ -1011,12 +1126,14 @@ void ast_smt_pp::display_smt2(std::ostream& strm, expr* n) {
 
     for (expr* a : m_assumptions_star) {
         smt_printer p(strm, m, ql, rn, m_logic, false, true, m_simplify_implies, 1);
+        p.set_cache(m_cache);
         strm << "(assert\n ";
         p(a);
         strm << ")\n";
     }
 
     smt_printer p(strm, m, ql, rn, m_logic, false, true, m_simplify_implies, 0);
+    p.set_cache(m_cache);
     if (m.is_bool(n)) {
         if (!m.is_true(n)) {
             strm << "(assert\n ";
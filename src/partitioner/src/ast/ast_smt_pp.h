@@ -22,6 +22,9 @@ Revision History:
 #include<string>
 #include "util/map.h"
 
+class decl_collector;
+class smt_printer;
+
 class smt_renaming {
     struct sym_b { symbol name; bool is_skolem; symbol name_aux; sym_b(symbol n, bool s): name(n), is_skolem(s) {} sym_b():name(),is_skolem(false) {}};
     typedef map<symbol, symbol, symbol_hash_proc, symbol_eq_proc> symbol2symbol;
@@ -48,6 +51,43 @@ public:
         virtual bool operator()(sort* s) const { return false; }
         virtual ~is_declared() = default;
     };
+
+    /**
+       \brief Printed text of terms and declarations kept across calls of display_smt2.
+
+       Benchmarks printed with the same cache share the renaming of symbols. The text
+       and the declarations of a non-Boolean compound term (outside quantifiers) are
+       computed once, by the first benchmark that contains it; later benchmarks copy
+       the text instead of walking the term. Terms in the cache are kept alive, so
+       their ids identify them.
+    */
+    class term_cache {
+        friend class ast_smt_pp;
+        friend class smt_printer;
+        struct entry {
+            bool           m_printed;
+            bool           m_collected;
+            std::string    m_text;
+            ptr_vector<ast> m_decls;   // declarations and sorts collected from the term
+            entry():m_printed(false), m_collected(false) {}
+        };
+        ast_manager &  m;
+        ast_ref_vector m_pinned;
+        u_map<entry*>  m_terms;
+        u_map<entry*>  m_func_decls;
+        smt_renaming   m_renaming;
+        ptr_vector<expr> m_todo;
+
+        entry & get(u_map<entry*> & map, ast * a);
+        entry & get(expr * e) { return get(m_terms, e); }
+        entry & get(func_decl * d) { return get(m_func_decls, d); }
+        bool is_stable(expr * e) const;
+        void collect_decls(decl_collector & decls, expr * n, ast_mark & visited);
+    public:
+        term_cache(ast_manager & m);
+        ~term_cache();
+        unsigned size() const { return m_terms.size(); }
+    };
 private:
     ast_manager& m_manager;
     expr_ref_vector m_assumptions;
@@ -62,6 +102,7 @@ private:
     is_declared m_is_declared_default;
     is_declared* m_is_declared;
     bool         m_simplify_implies;
+    term_cache*  m_cache;
 public:
     ast_smt_pp(ast_manager& m);
 
@@ -76,6 +117,7 @@ public:
     void set_simplify_implies(bool f) { m_simplify_implies = f; }
 
     void set_is_declared(is_declared* id) { m_is_declared = id; }
+    void set_term_cache(term_cache* c) { m_cache = c; }
 
     void display_smt2(std::ostream& strm, expr* n);
     void display_expr_smt2(std::ostream& strm, expr* n, unsigned indent = 0, unsigned num_var_names = 0, char const* const* var_names = nullptr);
@@ -0,0 +1,229 @@
+/*++
+Module Name:
+
+    main.cpp
+
+Abstract:
+
+    Micro-benchmark of the partitioner.
+
+    Every instance is partitioned in a child process, without a
+    coordinator and without solvers: the partitioning tactic runs
+    until it has written -tasks:N tasks (the tasks are never solved,
+    so all of them stay alive) and the timers of the partitioning
+    context are reported:
+
+        root      initialization and bound propagation (BICP) of the root
+        props/s   bounds derived per second of propagation
+        conv/s    nodes converted to tasks (convert_node_to_task) per second
+        split     average latency of split_node, including the propagation
+                  of the children
+        print/s   tasks printed per second
+        peak      peak memory of the child process
+
+    Usage: partitioner-bench [-tasks:N] [-outputdir:DIR] [param=value ...] file.smt2 ...
+
+    The task files are written to a temporary directory that is removed
+    at the end, unless -outputdir is given.
+
+Revision History:
+
+--*/
+#include "util/memory_manager.h"
+#include "util/gparams.h"
+#include "util/env_params.h"
+#include "util/z3_exception.h"
+#include "cmd_context/cmd_context.h"
+#include "parsers/smt2/smt2parser.h"
+#include "tactic/tactic.h"
+#include "math/subpaving/tactic/subpaving_tactic.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static unsigned                 g_num_tasks  = 64;
+static std::string              g_output_dir;
+static std::vector<std::string> g_files;
+
+static void usage() {
+    std::cerr << "usage: partitioner-bench [-tasks:N] [-outputdir:DIR] [param=value ...] file.smt2 ...\n";
+    exit(1);
+}
+
+static void parse_cmd_line_args(int argc, char ** argv) {
+    for (int i = 1; i < argc; ++i) {
+        char const * arg = argv[i];
+        if (strncmp(arg, "-tasks:", 7) == 0) {
+            g_num_tasks = static_cast<unsigned>(strtoul(arg + 7, nullptr, 10));
+            if (g_num_tasks == 0)
+                usage();
+        }
+        else if (strncmp(arg, "-outputdir:", 11) == 0)
+            g_output_dir = arg + 11;
+        else if (arg[0] == '-')
+            usage();
+        else if (char const * eq = strchr(arg, '=')) {
+            std::string name(arg, eq);
+            gparams::set(name.c_str(), eq + 1);
+        }
+        else
+            g_files.push_back(arg);
+    }
+    if (g_files.empty())
+        usage();
+}
+
+static double get_stat(statistics const & st, char const * key) {
+    for (unsigned i = 0, sz = st.size(); i < sz; ++i) {
+        if (strcmp(st.get_key(i), key) != 0)
+            continue;
+        return st.is_uint(i) ? st.get_uint_value(i) : st.get_double_value(i);
+    }
+    return 0;
+}
+
+static double ratio(double a, double b) {
+    return b > 0 ? a / b : 0;
+}
+
+// partition the instance in file, its line of the report is written to out
+static bool run_instance(std::string const & file, std::string const & dir, std::ostream & out) {
+    out << std::left << std::setw(32) << std::filesystem::path(file).filename().string() << std::right;
+    std::ifstream in(file);
+    if (!in) {
+        out << " cannot read file";
+        return false;
+    }
+    gparams::set("output_dir", dir.c_str());
+    // tasks are never finished, the limit of running tasks must not block partitioning
+    gparams::set("partition_max_tasks", std::to_string(g_num_tasks).c_str());
+    gparams::set("partition_max_running_tasks", std::to_string(g_num_tasks).c_str());
+    env_params::updt_params();
+
+    cmd_context ctx(false);
+    ctx.set_ignore_check(true);
+    if (!parse_smt2_commands(ctx, in)) {
+        out << " parse error";
+        return false;
+    }
+    ast_manager & m = ctx.m();
+    goal_ref g = alloc(goal, m, false, true, false);
+    for (expr * f : ctx.assertions())
+        g->assert_expr(f);
+
+    tactic_ref t = mk_subpaving_tactic(m);
+    goal_ref_buffer result;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    (*t)(g, result);
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    statistics st;
+    t->collect_statistics(st);
+
+    char const * status = "tasks";
+    if (is_decided_unsat(result))
+        status = "unsat";
+    else if (is_decided_sat(result))
+        status = "sat";
+    out << std::fixed
+        << std::setw(7)  << status
+        << std::setw(7)  << static_cast<unsigned>(get_stat(st, "printed tasks"))
+        << std::setprecision(3)
+        << std::setw(10) << get_stat(st, "root time")
+        << std::setprecision(0)
+        << std::setw(12) << ratio(get_stat(st, "new bounds"), get_stat(st, "propagation time"))
+        << std::setw(10) << ratio(get_stat(st, "converted nodes"), get_stat(st, "convert time"))
+        << std::setprecision(3)
+        << std::setw(10) << 1000 * ratio(get_stat(st, "split time"), get_stat(st, "split nodes"))
+        << std::setprecision(0)
+        << std::setw(10) << ratio(get_stat(st, "printed tasks"), get_stat(st, "task print time"))
+        << std::setprecision(2)
+        << std::setw(10) << static_cast<double>(memory::get_max_used_memory()) / (1024 * 1024)
+        << std::setprecision(3)
+        << std::setw(10) << total;
+    return true;
+}
+
+// the instance runs in a child process: it gets its own peak memory, and the lines
+// the partitioner writes to the coordinator (standard output) are dropped
+static void run_child(std::string const & file, std::string const & dir) {
+    int report = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_RDWR);
+    dup2(null_fd, STDIN_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+    std::ostringstream out;
+    bool ok;
+    try {
+        ok = run_instance(file, dir, out);
+    }
+    catch (z3_exception & ex) {
+        out << " error: " << ex.msg();
+        ok = false;
+    }
+    out << "\n";
+    std::string line = out.str();
+    if (write(report, line.data(), line.size()) < 0 || !ok)
+        _exit(1);
+    _exit(0);
+}
+
+int STD_CALL main(int argc, char ** argv) {
+    memory::initialize(0);
+    try {
+        parse_cmd_line_args(argc, argv);
+    }
+    catch (z3_exception & ex) {
+        std::cerr << "Error: " << ex.msg() << "\n";
+        return 1;
+    }
+    bool temporary = g_output_dir.empty();
+    if (temporary) {
+        char templ[] = "/tmp/partitioner-bench-XXXXXX";
+        if (mkdtemp(templ) == nullptr) {
+            std::cerr << "Error: cannot create a temporary directory\n";
+            return 1;
+        }
+        g_output_dir = templ;
+    }
+    std::cout << std::left << std::setw(32) << "instance" << std::right
+              << std::setw(7)  << "status"
+              << std::setw(7)  << "tasks"
+              << std::setw(10) << "root(s)"
+              << std::setw(12) << "props/s"
+              << std::setw(10) << "conv/s"
+              << std::setw(10) << "split(ms)"
+              << std::setw(10) << "print/s"
+              << std::setw(10) << "peak(MB)"
+              << std::setw(10) << "total(s)" << std::endl;
+    int ret = 0;
+    for (unsigned i = 0; i < g_files.size(); ++i) {
+        std::string dir = g_output_dir + "/" + std::to_string(i);
+        std::filesystem::create_directories(dir);
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid == 0)
+            run_child(g_files[i], dir);
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)) {
+            std::cout << std::filesystem::path(g_files[i]).filename().string() << " failed" << std::endl;
+            ret = 1;
+        }
+        else if (WEXITSTATUS(status) != 0)
+            ret = 1;
+    }
+    if (temporary) {
+        std::error_code ec;
+        std::filesystem::remove_all(g_output_dir, ec);
+    }
+    memory::finalize();
+    return ret;
+}
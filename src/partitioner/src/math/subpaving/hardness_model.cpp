@@ -0,0 +1,59 @@
+/*++
+Module Name:
+
+    hardness_model.cpp
+
+Abstract:
+
+    Cost models that predict the solving time of the task of a
+    partition node.
+
+Revision History:
+
+--*/
+#include <cmath>
+#include "math/subpaving/hardness_model.h"
+
+namespace subpaving {
+
+linear_hardness_model::linear_hardness_model(double rate):
+    m_bias(0.0),
+    m_rate(rate),
+    m_num_updates(0) {
+    for (unsigned i = 0; i < hardness_features::NUM_FEATURES; ++i)
+        m_weights[i] = 0.0;
+    m_weights[hardness_features::DEPTH]          = -0.1;
+    m_weights[hardness_features::UNDEF_LITS]     =  0.5;
+    m_weights[hardness_features::MAX_DEGREE]     =  0.1;
+    m_weights[hardness_features::UNBOUNDED_VARS] =  0.5;
+    m_weights[hardness_features::LOG_WIDTH]      =  0.05;
+}
+
+double linear_hardness_model::log_time(hardness_features const & f) const {
+    double r = m_bias;
+    for (unsigned i = 0; i < hardness_features::NUM_FEATURES; ++i)
+        r += m_weights[i] * f[i];
+    return r;
+}
+
+double linear_hardness_model::predict(hardness_features const & f) const {
+    double r = std::exp(log_time(f)) - 1.0;
+    return r < 0.0 ? 0.0 : r;
+}
+
+void linear_hardness_model::update(hardness_features const & f, double time) {
+    if (time < 0.0 || !std::isfinite(time))
+        return;
+    double err = std::log1p(time) - log_time(f);
+    // the bias is a feature whose value is always 1
+    double norm = 1.0;
+    for (unsigned i = 0; i < hardness_features::NUM_FEATURES; ++i)
+        norm += f[i] * f[i];
+    double step = m_rate * err / norm;
+    for (unsigned i = 0; i < hardness_features::NUM_FEATURES; ++i)
+        m_weights[i] += step * f[i];
+    m_bias += step;
+    ++m_num_updates;
+}
+
+};
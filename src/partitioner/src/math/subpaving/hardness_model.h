@@ -0,0 +1,83 @@
+/*++
+Module Name:
+
+    hardness_model.h
+
+Abstract:
+
+    Cost models that predict the solving time of the task of a
+    partition node. The partitioner orders its leaves with the
+    prediction, and the model is trained online with the solving
+    times reported by the coordinator.
+
+Revision History:
+
+--*/
+#pragma once
+
+namespace subpaving {
+
+/**
+   \brief Features of a partition node.
+*/
+struct hardness_features {
+    enum kind {
+        DEPTH,
+        UNDEF_CLAUSES,     // log(1 + number of undefined clauses)
+        UNDEF_LITS,        // log(1 + number of undefined literals)
+        AVG_CLAUSE_LEN,    // undefined literals per undefined clause
+        AVG_DEGREE,        // mean max degree of the variables of the undefined literals
+        MAX_DEGREE,        // max degree of the variables of the undefined literals
+        UNBOUNDED_VARS,    // fraction of arithmetic variables without a lower or an upper bound
+        LOG_WIDTH,         // mean log(1 + width) of the bounded arithmetic variables
+        PROP_YIELD,        // log(1 + number of bounds derived when the node was created)
+        NUM_FEATURES
+    };
+    double m_values[NUM_FEATURES];
+
+    hardness_features() { reset(); }
+    void reset() {
+        for (unsigned i = 0; i < NUM_FEATURES; ++i)
+            m_values[i] = 0.0;
+    }
+    double & operator[](unsigned i) { return m_values[i]; }
+    double operator[](unsigned i) const { return m_values[i]; }
+};
+
+/**
+   \brief Interface of the cost models.
+*/
+class hardness_model {
+public:
+    virtual ~hardness_model() = default;
+    /**
+       \brief Return the predicted solving time (in seconds) of a node with features f.
+    */
+    virtual double predict(hardness_features const & f) const = 0;
+    /**
+       \brief Record that a node with features f was solved in time seconds.
+    */
+    virtual void update(hardness_features const & f, double time) = 0;
+    virtual unsigned num_updates() const = 0;
+};
+
+/**
+   \brief Linear model of log(1 + time) trained with normalized least mean squares.
+   Before the first observations, the initial weights reproduce the static intuition:
+   larger tasks with wide boxes are harder, deeper nodes are easier.
+*/
+class linear_hardness_model : public hardness_model {
+    double   m_weights[hardness_features::NUM_FEATURES];
+    double   m_bias;
+    double   m_rate;
+    unsigned m_num_updates;
+
+    double log_time(hardness_features const & f) const;
+public:
+    linear_hardness_model(double rate);
+    double predict(hardness_features const & f) const override;
+    void update(hardness_features const & f, double time) override;
+    unsigned num_updates() const override { return m_num_updates; }
+};
+
+};
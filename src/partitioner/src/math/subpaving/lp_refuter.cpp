@@ -0,0 +1,300 @@
+/*++
+Module Name:
+
+    lp_refuter.cpp
+
+Abstract:
+
+    Exact feasibility check of linear rows and bounds, see lp_refuter.h.
+
+Revision History:
+
+--*/
+#include "math/subpaving/lp_refuter.h"
+
+namespace subpaving {
+
+    unsigned lp_refuter::row::find(unsigned x) const {
+        for (unsigned i = 0, sz = size(); i < sz; ++i)
+            if (m_vars[i] == x)
+                return i;
+        return UINT_MAX;
+    }
+
+    lp_refuter::lp_refuter(unsynch_mpq_manager & m):
+        m_manager(m),
+        m_lower(m),
+        m_upper(m),
+        m_value(m),
+        m_input_coeffs(m),
+        m_num_entries(0),
+        m_num_pivots(0),
+        m_acc(m) {
+    }
+
+    lp_refuter::~lp_refuter() {
+        del_rows();
+    }
+
+    void lp_refuter::del_rows() {
+        for (row * r : m_rows)
+            dealloc(r);
+        m_rows.reset();
+    }
+
+    void lp_refuter::reset() {
+        m_lower.reset();
+        m_upper.reset();
+        m_has_lower.reset();
+        m_has_upper.reset();
+        m_value.reset();
+        m_input_basic.reset();
+        m_input_begin.reset();
+        m_input_vars.reset();
+        m_input_coeffs.reset();
+        del_rows();
+        m_row_of.reset();
+        m_cols.reset();
+        m_num_entries = 0;
+        m_num_pivots = 0;
+        m_acc.reset();
+        m_acc_vars.reset();
+        m_acc_mark.reset();
+        m_var_mark.reset();
+        m_row_mark.reset();
+    }
+
+    unsigned lp_refuter::mk_var() {
+        unsigned x = num_vars();
+        m_lower.push_back(mpq());
+        m_upper.push_back(mpq());
+        m_has_lower.push_back(false);
+        m_has_upper.push_back(false);
+        m_value.push_back(mpq());
+        m_row_of.push_back(UINT_MAX);
+        m_cols.push_back(unsigned_vector());
+        m_acc.push_back(mpq());
+        m_acc_mark.push_back(false);
+        m_var_mark.push_back(false);
+        return x;
+    }
+
+    void lp_refuter::set_lower(unsigned x, mpq const & l) {
+        if (m_has_lower[x] && m().ge(m_lower[x], l))
+            return;
+        m().set(m_lower[x], l);
+        m_has_lower[x] = true;
+    }
+
+    void lp_refuter::set_upper(unsigned x, mpq const & u) {
+        if (m_has_upper[x] && m().le(m_upper[x], u))
+            return;
+        m().set(m_upper[x], u);
+        m_has_upper[x] = true;
+    }
+
+    void lp_refuter::add_row(unsigned b, unsigned sz, unsigned const * xs, mpq const * as) {
+        m_input_basic.push_back(b);
+        m_input_begin.push_back(m_input_vars.size());
+        for (unsigned i = 0; i < sz; ++i) {
+            m_input_vars.push_back(xs[i]);
+            m_input_coeffs.push_back(as[i]);
+        }
+    }
+
+    void lp_refuter::acc_add(unsigned x, mpq const & a) {
+        if (m_acc_mark[x]) {
+            m().add(m_acc[x], a, m_acc[x]);
+            return;
+        }
+        m_acc_mark[x] = true;
+        m_acc_vars.push_back(x);
+        m().set(m_acc[x], a);
+    }
+
+    void lp_refuter::acc_add_row(row const & r, mpq const & k, unsigned skip) {
+        scoped_mpq tmp(m());
+        for (unsigned i = 0, sz = r.size(); i < sz; ++i) {
+            if (r.m_vars[i] == skip)
+                continue;
+            m().mul(k, r.m_coeffs[i], tmp);
+            acc_add(r.m_vars[i], tmp);
+        }
+    }
+
+    void lp_refuter::acc_store(unsigned ri) {
+        row & r = *m_rows[ri];
+        for (unsigned x : r.m_vars)
+            m_var_mark[x] = true;
+        m_num_entries -= r.size();
+        r.m_vars.reset();
+        r.m_coeffs.reset();
+        for (unsigned x : m_acc_vars) {
+            m_acc_mark[x] = false;
+            if (m().is_zero(m_acc[x]))
+                continue;
+            if (!m_var_mark[x])
+                m_cols[x].push_back(ri);
+            r.m_vars.push_back(x);
+            r.m_coeffs.push_back(m_acc[x]);
+        }
+        m_acc_vars.reset();
+        for (unsigned x : r.m_vars)
+            m_var_mark[x] = false;
+        m_num_entries += r.size();
+    }
+
+    void lp_refuter::collect_rows(unsigned x, unsigned_vector & rs) {
+        rs.reset();
+        unsigned_vector & col = m_cols[x];
+        unsigned j = 0;
+        for (unsigned r : col) {
+            if (m_row_mark[r] || m_rows[r]->find(x) == UINT_MAX)
+                continue;
+            m_row_mark[r] = true;
+            col[j++] = r;
+            rs.push_back(r);
+        }
+        col.shrink(j);
+        for (unsigned r : rs)
+            m_row_mark[r] = false;
+    }
+
+    bool lp_refuter::build_tableau(unsigned max_entries) {
+        unsigned_vector rs;
+        scoped_mpq k(m()), one(m());
+        m().set(one, 1);
+        for (unsigned i = 0, num_r = num_rows(); i < num_r; ++i) {
+            unsigned b = m_input_basic[i];
+            unsigned end = i + 1 < num_r ? m_input_begin[i + 1] : m_input_vars.size();
+            for (unsigned j = m_input_begin[i]; j < end; ++j) {
+                unsigned x = m_input_vars[j];
+                if (m_row_of[x] == UINT_MAX)
+                    acc_add(x, m_input_coeffs[j]);
+                else // x is basic, its row is substituted
+                    acc_add_row(*m_rows[m_row_of[x]], m_input_coeffs[j], UINT_MAX);
+            }
+            unsigned ri = m_rows.size();
+            m_rows.push_back(alloc(row, m(), b));
+            m_row_mark.push_back(false);
+            acc_store(ri);
+            // b is eliminated from the previous rows
+            collect_rows(b, rs);
+            for (unsigned s : rs) {
+                row const & r = *m_rows[s];
+                m().set(k, r.m_coeffs[r.find(b)]);
+                acc_add_row(r, one, b);
+                acc_add_row(*m_rows[ri], k, UINT_MAX);
+                acc_store(s);
+            }
+            m_row_of[b] = ri;
+            if (m_num_entries > max_entries)
+                return false;
+        }
+        return true;
+    }
+
+    void lp_refuter::pivot_and_update(unsigned r, unsigned y, mpq const & v) {
+        row & R = *m_rows[r];
+        unsigned x = R.m_basic;
+        unsigned_vector rs;
+        scoped_mpq a(m()), theta(m()), tmp(m()), one(m());
+        m().set(one, 1);
+        m().set(a, R.m_coeffs[R.find(y)]);
+        // theta = (v - value(x)) / a_ry
+        m().sub(v, m_value[x], theta);
+        m().div(theta, a, theta);
+        m().set(m_value[x], v);
+        m().add(m_value[y], theta, m_value[y]);
+        collect_rows(y, rs);
+        for (unsigned s : rs) {
+            if (s == r)
+                continue;
+            row const & S = *m_rows[s];
+            m().mul(S.m_coeffs[S.find(y)], theta, tmp);
+            m().add(m_value[S.m_basic], tmp, m_value[S.m_basic]);
+        }
+        // x = a_ry y + sum a_rz z  becomes  y = x / a_ry - sum a_rz / a_ry z
+        for (unsigned i = 0, sz = R.size(); i < sz; ++i) {
+            if (R.m_vars[i] == y)
+                continue;
+            m().div(R.m_coeffs[i], a, tmp);
+            m().neg(tmp);
+            acc_add(R.m_vars[i], tmp);
+        }
+        m().inv(a, tmp);
+        acc_add(x, tmp);
+        R.m_basic = y;
+        acc_store(r);
+        for (unsigned s : rs) {
+            if (s == r)
+                continue;
+            row const & S = *m_rows[s];
+            m().set(a, S.m_coeffs[S.find(y)]);
+            acc_add_row(S, one, y);
+            acc_add_row(R, a, UINT_MAX);
+            acc_store(s);
+        }
+        m_row_of[y] = r;
+        m_row_of[x] = UINT_MAX;
+        ++m_num_pivots;
+    }
+
+    lbool lp_refuter::check(unsigned max_entries, unsigned max_pivots) {
+        unsigned n = num_vars();
+        for (unsigned x = 0; x < n; ++x) {
+            if (m_has_lower[x] && m_has_upper[x] && m().gt(m_lower[x], m_upper[x]))
+                return l_false;
+        }
+        if (!build_tableau(max_entries))
+            return l_undef;
+        for (unsigned x = 0; x < n; ++x) {
+            if (m_row_of[x] != UINT_MAX)
+                continue;
+            if (m_has_lower[x])
+                m().set(m_value[x], m_lower[x]);
+            else if (m_has_upper[x])
+                m().set(m_value[x], m_upper[x]);
+        }
+        scoped_mpq tmp(m());
+        for (row * r : m_rows) {
+            mpq & v = m_value[r->m_basic];
+            m().reset(v);
+            for (unsigned i = 0, sz = r->size(); i < sz; ++i) {
+                m().mul(r->m_coeffs[i], m_value[r->m_vars[i]], tmp);
+                m().add(v, tmp, v);
+            }
+        }
+        while (true) {
+            // Bland's rule: the smallest violated basic variable, the smallest suitable nonbasic one
+            unsigned x = UINT_MAX;
+            for (unsigned y = 0; y < n; ++y) {
+                if (m_row_of[y] != UINT_MAX && (below_lower(y) || above_upper(y))) {
+                    x = y;
+                    break;
+                }
+            }
+            if (x == UINT_MAX)
+                return l_true;
+            if (m_num_pivots >= max_pivots || m_num_entries > max_entries)
+                return l_undef;
+            row const & r = *m_rows[m_row_of[x]];
+            bool increase = below_lower(x);
+            unsigned y = UINT_MAX;
+            for (unsigned i = 0, sz = r.size(); i < sz; ++i) {
+                unsigned z = r.m_vars[i];
+                if (z >= y)
+                    continue;
+                // z has to move in the direction that moves x towards its violated bound
+                bool up = m().is_pos(r.m_coeffs[i]) == increase;
+                if (up ? (!m_has_upper[z] || m().lt(m_value[z], m_upper[z]))
+                       : (!m_has_lower[z] || m().gt(m_value[z], m_lower[z])))
+                    y = z;
+            }
+            if (y == UINT_MAX)
+                return l_false;
+            pivot_and_update(m_row_of[x], y, increase ? m_lower[x] : m_upper[x]);
+        }
+    }
+
+};
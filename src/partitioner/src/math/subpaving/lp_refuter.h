@@ -0,0 +1,99 @@
+/*++
+Module Name:
+
+    lp_refuter.h
+
+Abstract:
+
+    Exact feasibility check of a system of linear rows and bounds,
+    used by the partitioner to refute the linear relaxation of a node
+    before its task is written.
+
+    Every row defines a basic variable as a linear combination of
+    other variables:  b = a_1 x_1 + ... + a_n x_n, and every variable
+    may have a lower and an upper bound (non-strict). The check is the
+    bounded-variable simplex of Dutertre and de Moura with Bland's
+    rule over rationals, on a sparse tableau.
+
+Revision History:
+
+--*/
+#pragma once
+
+#include "util/mpq.h"
+#include "util/lbool.h"
+#include "util/vector.h"
+
+namespace subpaving {
+
+class lp_refuter {
+    struct row {
+        unsigned          m_basic;
+        unsigned_vector   m_vars;
+        scoped_mpq_vector m_coeffs;
+        row(unsynch_mpq_manager & m, unsigned b):m_basic(b), m_coeffs(m) {}
+        unsigned size() const { return m_vars.size(); }
+        unsigned find(unsigned x) const;
+    };
+
+    unsynch_mpq_manager & m_manager;
+    scoped_mpq_vector     m_lower;
+    scoped_mpq_vector     m_upper;
+    bool_vector           m_has_lower;
+    bool_vector           m_has_upper;
+    scoped_mpq_vector     m_value;
+    // rows in construction: basic variable and (variable, coefficient) entries
+    unsigned_vector       m_input_basic;
+    unsigned_vector       m_input_begin;
+    unsigned_vector       m_input_vars;
+    scoped_mpq_vector     m_input_coeffs;
+    // tableau: the basic variables of the rows only occur in their rows
+    ptr_vector<row>       m_rows;
+    unsigned_vector       m_row_of;           // row of a basic variable, UINT_MAX for nonbasic ones
+    vector<unsigned_vector> m_cols;           // rows in which a variable may occur (a superset)
+    unsigned              m_num_entries;
+    unsigned              m_num_pivots;
+    // row combination buffer
+    scoped_mpq_vector     m_acc;
+    unsigned_vector       m_acc_vars;
+    bool_vector           m_acc_mark;
+    bool_vector           m_var_mark;
+    bool_vector           m_row_mark;
+
+    unsynch_mpq_manager & m() const { return m_manager; }
+    bool below_lower(unsigned x) const { return m_has_lower[x] && m().lt(m_value[x], m_lower[x]); }
+    bool above_upper(unsigned x) const { return m_has_upper[x] && m().gt(m_value[x], m_upper[x]); }
+    void del_rows();
+    void acc_add(unsigned x, mpq const & a);
+    void acc_add_row(row const & r, mpq const & k, unsigned skip);
+    void acc_store(unsigned r);
+    void collect_rows(unsigned x, unsigned_vector & rs);
+    bool build_tableau(unsigned max_entries);
+    void pivot_and_update(unsigned r, unsigned y, mpq const & v);
+public:
+    lp_refuter(unsynch_mpq_manager & m);
+    ~lp_refuter();
+
+    void reset();
+    unsigned num_vars() const { return m_has_lower.size(); }
+    unsigned num_rows() const { return m_input_basic.size(); }
+    unsigned num_pivots() const { return m_num_pivots; }
+
+    unsigned mk_var();
+    void set_lower(unsigned x, mpq const & l);
+    void set_upper(unsigned x, mpq const & u);
+
+    /**
+       \brief Add the row b = sum as[i] * xs[i]. A variable is the basic variable of at most one row.
+    */
+    void add_row(unsigned b, unsigned sz, unsigned const * xs, mpq const * as);
+
+    /**
+       \brief Return l_false if the system is infeasible, l_true if it is feasible,
+       and l_undef if the tableau gets more than max_entries nonzero entries or more
+       than max_pivots pivots are needed.
+    */
+    lbool check(unsigned max_entries, unsigned max_pivots);
+};
+
+};
@@ -46,6 +46,8 @@ namespace subpaving {
         void display_constraints(std::ostream & out, bool use_star) const override { m_ctx.display_constraints(out, use_star); }
         void set_task_ptr(task_info * p) override { m_ctx.set_task_ptr(p); }
         void set_display_proc(display_var_proc * p) override { m_ctx.set_display_proc(p); }
+        void set_models_enabled(bool f) override { m_ctx.set_models_enabled(f); }
+        bool found_model() const override { return m_ctx.found_model(); }
         void reset_statistics() override { m_ctx.reset_statistics(); }
         void collect_statistics(statistics & st) const override { m_ctx.collect_statistics(st); }
         void collect_param_descrs(param_descrs & r) override { m_ctx.collect_param_descrs(r); }
@@ -66,6 +68,9 @@ namespace subpaving {
 
         unsynch_mpq_manager & qm() const override { return m_ctx.nm(); }
 
+        mpq const & model_value(var x) const override { return m_ctx.model_value(x); }
+        void set_root_cache(std::string const & path) override { m_ctx.set_root_cache(path); }
+
         var mk_sum(unsigned sz, mpz const * as, var const * xs) override {
             m_as.reserve(sz);
             for (unsigned i = 0; i < sz; i++) {
@@ -29,6 +29,7 @@ Revision History:
 #include "util/params.h"
 #include "util/statistics.h"
 #include "util/lbool.h"
+#include <string>
 
 namespace subpaving {
 
@@ -102,6 +103,26 @@ public:
     
     virtual void set_display_proc(display_var_proc * p) = 0;
 
+    /**
+       \brief Allow operator() to stop with a model found in the box of a node (see found_model).
+       The caller must be able to build a model from the values of the variables.
+    */
+    virtual void set_models_enabled(bool f) = 0;
+
+    /**
+       \brief Return true if the last call of operator() found a model, the value of x is model_value(x)
+       (0 or 1 for a boolean variable).
+    */
+    virtual bool found_model() const = 0;
+
+    virtual mpq const & model_value(var x) const = 0;
+
+    /**
+       \brief Set the file of the root bounds: they are read from it if it exists,
+       and saved to it after the root is propagated otherwise.
+    */
+    virtual void set_root_cache(std::string const & path) = 0;
+
     virtual void reset_statistics() = 0;
 
     virtual void collect_statistics(statistics & st) const = 0;
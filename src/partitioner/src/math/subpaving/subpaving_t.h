@@ -25,11 +25,15 @@ Revision History:
 #include "math/interval/interval.h"
 #include "util/scoped_numeral_vector.h"
 #include "math/subpaving/subpaving_types.h"
+#include "math/subpaving/hardness_model.h"
+#include "math/subpaving/tree_journal.h"
+#include "math/subpaving/lp_refuter.h"
 #include "util/params.h"
 #include "util/statistics.h"
 #include "util/lbool.h"
 #include "util/rlimit.h"
 
+#include <fstream>
 #include <ostream>
 #include <queue>
 #include <random>
@@ -124,6 +128,7 @@ public:
         unsigned m_lemma:1;         //!< True if it is a learned clause.
         unsigned m_watched:1;       //!< True if it we are watching this clause. All non-lemmas are watched.
         unsigned m_num_jst:30;      //!< Number of times it is used to justify some bound.
+        unsigned m_watch[2];        //!< Positions of the two watched atoms.
         atom *   m_atoms[0];
         static unsigned get_obj_size(unsigned sz) { return sizeof(clause) + sz*sizeof(atom*); }
     public:
@@ -236,6 +241,29 @@ public:
     void dec_ref(bvalue_kind) {}
     void inc_ref(bvalue_kind) {}
 
+    /**
+       \brief Replacement of a watched atom performed while propagating a node.
+       The watch trail of a node is undone/replayed when propagation switches to another branch.
+    */
+    struct watch_move {
+        clause * m_clause;
+        unsigned m_slot;
+        unsigned m_old;
+        unsigned m_new;
+        watch_move(clause * c, unsigned slot, unsigned old_idx, unsigned new_idx):
+            m_clause(c), m_slot(slot), m_old(old_idx), m_new(new_idx) {}
+    };
+
+    /**
+       \brief Atom derived by unit propagation at a node.
+       Cells are shared: the list of a node continues with the list of its parent,
+       so a child only allocates the atoms it derives itself.
+    */
+    struct up_atom_cell {
+        atom *         m_atom;
+        up_atom_cell * m_next;
+    };
+
     /**
        \brief Node in the context_t.
     */
@@ -255,10 +283,25 @@ public:
         // Doubly linked list of leaves to be processed
         node *                m_prev;
         node *                m_next;
-        unsigned_vector       m_key_rank;
-        unsigned_vector       m_split_vars;
-        // atoms by unit propagation
-        ptr_vector<atom>      m_up_atoms;
+    public:
+        static const unsigned num_keys = 5;
+    private:
+        unsigned              m_key_rank[num_keys];
+        // variable split to create this node (null_var at the root),
+        // the split path of a node is obtained by following the parent links.
+        var                   m_split_var;
+        // atoms by unit propagation (shared with the ancestors)
+        up_atom_cell *        m_up_atoms;
+        // up atoms of the parent when this node was created, cells before it are owned by this node
+        up_atom_cell *        m_parent_up_atoms;
+        // watch moves performed while propagating this node
+        svector<watch_move>   m_watch_trail;
+        // variables of the bounds left in the queue when the propagation of this node ran out
+        // of budget, the clauses watching them are visited again at the children
+        svector<var>          m_pending_watch_vars;
+        // number of lemmas (clauses and units) already checked at this node
+        unsigned              m_num_lemmas;
+        unsigned              m_num_unit_lemmas;
     public:
         node(context_t & s, unsigned id, bool_vector &is_bool);
         node(node * parent, unsigned id);
@@ -268,9 +311,10 @@ public:
         bvalue_array_manager & bvm() const { return m_bvm; }
         bound_array & lowers() { return m_lowers; }
         bound_array & uppers() { return m_uppers; }
+        bvalue_array & bvalues() { return m_bvalue; }
         bool inconsistent() const { return m_conflict != null_var; }
         void set_conflict(var x) { SASSERT(!inconsistent()); m_conflict = x; }
-        var get_conflict_var() { SASSERT(!inconsistent()); return m_conflict; }
+        var get_conflict_var() { SASSERT(inconsistent()); return m_conflict; }
         bound * trail_stack() const { return m_trail; }
         bound * parent_trail_stack() const { return m_parent == nullptr ? nullptr : m_parent->m_trail; }
         bound * lower(var x) const { return bm().get(m_lowers, x); }
@@ -296,9 +340,17 @@ public:
 
         unsigned depth() const { return m_depth; }
         
-        unsigned_vector & key_rank() { return m_key_rank; }
-        unsigned_vector & split_vars() { return m_split_vars; }
-        ptr_vector<atom> & up_atoms() { return m_up_atoms; }
+        unsigned * key_rank() { return m_key_rank; }
+        var split_var() const { return m_split_var; }
+        void set_split_var(var x) { m_split_var = x; }
+        up_atom_cell * up_atoms() const { return m_up_atoms; }
+        up_atom_cell * parent_up_atoms() const { return m_parent_up_atoms; }
+        void push_up_atom(up_atom_cell * c) { SASSERT(c->m_next == m_up_atoms); m_up_atoms = c; }
+        svector<watch_move> & watch_trail() { return m_watch_trail; }
+        svector<var> & pending_watch_vars() { return m_pending_watch_vars; }
+        unsigned num_lemmas() const { return m_num_lemmas; }
+        unsigned num_unit_lemmas() const { return m_num_unit_lemmas; }
+        void set_num_lemmas(unsigned num, unsigned num_units) { m_num_lemmas = num; m_num_unit_lemmas = num_units; }
     };
     
     /**
@@ -426,7 +478,9 @@ public:
        - A clause
        - A definition (i.e., a variable)
 
-       Remark: we cannot use the two watched literal approach since we process multiple nodes.
+       Remark: clauses use the two watched literal approach (see m_clause_wlist).
+       Since we process multiple nodes, the watch moves performed at each node are recorded
+       in its watch trail, and undone/replayed when we switch to a different branch.
     */
     class watched {
     public:
@@ -451,14 +505,18 @@ public:
         unsigned m_depth;
         unsigned m_undef_clause_num;
         unsigned m_undef_lit_num;
-        node_info(unsigned _id, unsigned _depth, unsigned _ucn, unsigned _uln):
-            m_id(_id), m_depth(_depth), m_undef_clause_num(_ucn), m_undef_lit_num(_uln) {}
+        double   m_hardness; // predicted solving time, 0 if there is no cost model
+        node_info(unsigned _id, unsigned _depth, unsigned _ucn, unsigned _uln, double _hardness):
+            m_id(_id), m_depth(_depth), m_undef_clause_num(_ucn), m_undef_lit_num(_uln), m_hardness(_hardness) {}
         // greater means need to split earlier
+        // (hardness = 2) > (hardness = 1)
         // (depth = 1) > (depth = 2)
         // (undef_clause_num = 1) < (undef_clause_num = 2)
         // (undef_lit_num = 1) < (undef_lit_num = 2)
         // (id = 1) > (id = 2)
         bool operator < (const node_info & rhs) const {
+            if (m_hardness != rhs.m_hardness)
+                return m_hardness < rhs.m_hardness;
             if (m_depth != rhs.m_depth)
                 return m_depth > rhs.m_depth;
             if (m_undef_clause_num != rhs.m_undef_clause_num)
@@ -737,6 +795,7 @@ public:
     bool is_definition(var x) const { return m_defs[x] != 0; }
     
     typedef svector<watched> watch_list;
+    typedef ptr_vector<clause> clause_watch_list;
     typedef _scoped_numeral_vector<numeral_manager> scoped_numeral_vector;
 
 private:
@@ -749,6 +808,17 @@ private:
     bvalue_array_manager      m_bvm;
     interval_manager          m_im;
     scoped_numeral_vector     m_num_buffer;
+    // Contributions a_i * z_i of the terms of a polynomial, used by propagate_polynomial
+    scoped_numeral_vector     m_term_lowers;
+    scoped_numeral_vector     m_term_uppers;
+    // Point evaluated by the SAT fast path (see find_model), booleans are 0 or 1.
+    scoped_numeral_vector     m_model;
+    ptr_vector<bound>         m_term_lower_bounds; //!< Bound producing the lower end of a term (nullptr if -oo)
+    ptr_vector<bound>         m_term_upper_bounds; //!< Bound producing the upper end of a term (nullptr if +oo)
+    // Double precision approximations of the coefficients and contributions of the terms, used by may_improve_polynomial
+    svector<double>           m_approx_as;
+    svector<double>           m_approx_lowers;
+    svector<double>           m_approx_uppers;
 
     bool_vector               m_is_int;
     bool_vector               m_is_bool;
@@ -756,10 +826,15 @@ private:
     // vector<bvalue_kind>       m_bvalue;
     ptr_vector<definition>    m_defs;
     vector<watch_list>        m_wlist;
+    // Clauses watching an atom on x. Entries become stale when a watch moves, they are dropped when the list is visited.
+    vector<clause_watch_list> m_clause_wlist;
+    node *                    m_watch_node;       //!< Node whose state is reflected by the clause watches.
+    unsigned                  m_num_watch_pushes; //!< Entries added to m_clause_wlist since the last rebuild.
 
     ptr_vector<atom>          m_unit_clauses;
     ptr_vector<clause>        m_clauses;
     ptr_vector<clause>        m_lemmas;
+    ptr_vector<atom>          m_unit_lemmas;
     //#linxi clauses after root node BICP
     bool                      m_root_bicp_done;
     vector<watch_list>        m_bicp_wlist;
@@ -793,15 +868,64 @@ private:
     unsigned                  m_max_depth;       //!< Maximum depth
     unsigned                  m_max_nodes;       //!< Maximum number of nodes in the tree
     unsigned long long        m_max_memory;      // in bytes
+    bool                      m_fp_filter;       //!< Screen polynomial and monomial propagation using double precision arithmetic (partition_fp_filter)
 
     //#linxi
     unsigned            m_max_propagate;
     unsigned            m_curr_propagate;
-    unsigned            m_root_max_prop_time;
-    unsigned            m_max_prop_time;
+    unsigned            m_root_max_prop_ms;   //!< Propagation budget (in milliseconds) at the root
+    unsigned            m_max_prop_ms;        //!< Propagation budget (in milliseconds) at other nodes
+    unsigned            m_max_prop_work;      //!< Maximum number of work units per propagation (0: unlimited)
+    double              m_prop_yield;         //!< Moving average of new bounds per work unit
+    unsigned            m_num_prop_samples;
+    unsigned            m_lookahead;          //!< Number of split candidates compared by lookahead (0: disabled)
+    unsigned            m_lookahead_ms;       //!< Time budget (in milliseconds) of a lookahead
+    bool                m_in_lookahead;
+    // Best split candidates of the current node, ordered by decreasing score.
+    svector<std::pair<double, var>> m_lookahead_vars;
+    // Split bound of the candidate selected by the lookahead.
+    numeral             m_lookahead_mid;
+    bool                m_lookahead_lower;
+    bool                m_lookahead_open;
+    bool                m_lookahead_bound_ready;
+    bool                m_learn_lemmas;       //!< Learn lemmas from inconsistent nodes
+    bool                m_export_lemmas;      //!< Add the learned lemmas to the tasks
+    // (variable, bound kind) pairs whose latest bound is needed by the conflict analysis, indexed by 2*x + lower.
+    bool_vector         m_lemma_need;
+    hardness_model *    m_hardness_model;     //!< Cost model ordering the leaves (nullptr: static order)
+    // Features of the nodes, indexed by node id, the model is trained with them when a solving time is reported.
+    svector<hardness_features> m_node_features;
+    lp_refuter *        m_lp_refuter;         //!< Check of the linear relaxation of the nodes (nullptr: disabled)
+    unsigned            m_lp_max_pivots;      //!< Pivot budget of a check of the linear relaxation
+    // LP variable of each variable in the current check, UINT_MAX if it was not used yet.
+    unsigned_vector     m_lp_vars;
+    unsigned            m_sat_samples;        //!< Points of the box of a node evaluated before its task is written (0: tasks without clauses only)
+    bool                m_models_enabled;     //!< The caller can build a model from the values of the variables
+    bool                m_found_model;
+    // The sampling has its own generator, the splits do not depend on it.
+    std::mt19937        m_sample_rand;
+    unsigned_vector     m_lemma_need_idxs;
+
+    /**
+       \brief Random generator that counts its draws, so that its state
+       can be restored from the seed (see replay_journal).
+    */
+    class counting_rand {
+        std::mt19937 m_engine;
+        uint64_t     m_draws;
+    public:
+        typedef std::mt19937::result_type result_type;
+        static constexpr result_type min() { return std::mt19937::min(); }
+        static constexpr result_type max() { return std::mt19937::max(); }
+        counting_rand():m_draws(0) {}
+        void seed(unsigned s) { m_engine.seed(s); m_draws = 0; }
+        void discard(uint64_t n) { m_engine.discard(n); m_draws += n; }
+        uint64_t draws() const { return m_draws; }
+        result_type operator()() { ++m_draws; return m_engine(); }
+    };
 
     unsigned            m_rand_seed;
-    std::mt19937        m_rand;
+    counting_rand       m_rand;
     unsigned            m_var_key_num;
     var_info            m_best_var_info;
     var_info            m_curr_var_info;
@@ -835,7 +959,35 @@ private:
     unsigned            m_read_buffer_tail;
     std::string         m_current_line;
     bool                m_partitioner_debug;
+    // debug lines have their own channel (partitioner-debug.txt in the output dir)
+    std::ofstream       m_debug_out;
     std::stringstream   m_temp_stringstream;
+    // Journal of the tree, from which a restarted partitioner rebuilds it (partition_snapshot).
+    tree_journal        m_journal;
+    // No line is sent to the coordinator while a journal is replayed, it already knows the nodes.
+    bool                m_replaying;
+    // File of the root bounds of a previous partitioner on the same goal, empty if there is no cache.
+    std::string         m_root_cache;
+
+    /**
+       \brief Split of a node of a subtree exported by another partitioner (see export_subtree).
+       The first child gets the bound, the second one its negation.
+    */
+    struct imported_split {
+        var         m_var;
+        bool        m_lower;
+        bool        m_open;
+        std::string m_value;
+        unsigned    m_first;    // ids of the children in the exported subtree
+        unsigned    m_second;
+    };
+    vector<imported_split> m_imported_splits;
+    // Node id -> 1 + index of its imported split, 0 if the node is split as usual.
+    unsigned_vector     m_node_import;
+    // Id in the exported subtree -> 1 + index of its split, 0 if it is a leaf.
+    unsigned_vector     m_import_split_of;
+    // Ids in the exported subtree of the nodes the other partitioner knew to be unsat.
+    bool_vector         m_import_unsat;
     
     unsigned            m_alive_task_num;
     unsigned            m_unsolved_task_num;
@@ -851,8 +1003,23 @@ private:
         TERMINATED,
     };
     vector<node_state>  m_nodes_state;
+    // Nodes that became UNSAT or TERMINATED since the last garbage collection.
+    unsigned_vector     m_gc_candidates;
+    bool                m_gc;                 //!< Free the nodes of solved subtrees
     std::priority_queue<node_info> m_leaf_heap;
 
+    // Clauses that are not satisfied at a converted node, used to build the tasks of its children.
+    // Each clause is encoded as: index in m_clauses, number k of undefined atoms, positions of the k atoms.
+    vector<unsigned_vector> m_task_residuals;
+    bool_vector         m_task_residual_valid;
+    // Variables whose bounds changed in the node being converted w.r.t. its parent.
+    bool_vector         m_changed_var;
+    unsigned_vector     m_changed_vars;
+    // Subsumption index of remove_dominated_clauses: occurrence lists and counts keyed by lit_key.
+    vector<unsigned_vector> m_subsume_occs;
+    unsigned_vector     m_subsume_cnts;
+    unsigned_vector     m_subsume_keys;
+
     //#linxi mpz is a temporary hack
     mpz                       m_max_denominator;
     mpz                       m_adjust_denominator;
@@ -862,6 +1029,7 @@ private:
     task_info               m_bicp_task;
     // unsigned                m_task_num;
     ptr_buffer<atom>        m_temp_atom_buffer;
+    buffer<unsigned>        m_temp_pos_buffer;
     unsigned                m_conj_simplified_cnt;
     unsigned                m_disj_simplified_cnt;
     unsigned                m_skip_clause_cnt;
@@ -877,9 +1045,32 @@ private:
     unsigned                  m_num_mk_bounds;
     unsigned                  m_num_splits;
     unsigned                  m_num_visited;
+    unsigned                  m_num_watch_moves;
+    unsigned                  m_num_fp_filtered;
+    unsigned                  m_num_prop_exhausted;
+    unsigned                  m_num_pending_watch_vars;
+    unsigned                  m_num_prop_extended;
+    unsigned                  m_num_prop_work;
+    unsigned                  m_num_lookahead_probes;
+    unsigned                  m_num_lookahead_changes;
+    unsigned                  m_num_lemmas;
+    unsigned                  m_num_collected_nodes;
+    unsigned                  m_num_hardness_updates;
+    unsigned                  m_num_lp_checks;
+    unsigned                  m_num_lp_refuted;
+    unsigned                  m_num_sat_samples;
+    unsigned                  m_num_split_nodes;
+    unsigned                  m_num_converted_nodes;
+    // Timers (in seconds): initialization and propagation of the root, all propagations,
+    // split_node (including the propagation of the children), convert_node_to_task
+    double                    m_root_time;
+    double                    m_prop_time;
+    double                    m_split_time;
+    double                    m_convert_time;
     
     // Temporary
     numeral                   m_tmp1, m_tmp2, m_tmp3;
+    numeral                   m_sum_lower, m_sum_upper, m_term_bound;
     mpz                       m_ztmp1;
     interval                  m_i_tmp1, m_i_tmp2, m_i_tmp3;
 
@@ -925,6 +1116,8 @@ private:
     node * mk_node(node * parent = nullptr);
     void del_node(node * n);
     void del_nodes();
+    void push_up_atom(node * n, atom * a);
+    void del_up_atoms(node * n);
 
     void del(interval & a);
     void del_clauses(ptr_vector<clause> & cs);
@@ -1050,16 +1243,135 @@ private:
 
     /**
        \brief Propagate new bounds at node n using get_polynomial(x)
+       The bounds of x and of all variables in the polynomial are derived in a single pass.
        \pre is_polynomial(x)
     */
     void propagate_polynomial(var x, node * n);
-    // Propagate a new bound for y using the polynomial associated with x. x may be equal to y.
-    void propagate_polynomial(var x, node * n, var y);
+    // Propagate the bound val for y using the polynomial associated with x, if it is relevant.
+    void propagate_polynomial_bound(var x, node * n, var y, numeral const & val, bool lower, bool open);
+
+    /**
+       \brief Store in r the double closest to a. Return false if a is not a small rational.
+       The numerator and denominator of a small rational are exact doubles, so r is correctly rounded.
+    */
+    bool approx(numeral const & a, double & r);
+
+    /**
+       \brief Return false if the new bound v (+/- err) for z cannot improve the current one at node n.
+    */
+    bool fp_may_improve(var z, double v, double err, bool lower, node * n);
+
+    /**
+       \brief Enclosure [lo, hi] of a rational, computed in double precision with outward rounding.
+    */
+    struct fp_encl {
+        double m_lo;
+        double m_hi;
+    };
+
+    /**
+       \brief Enclosures of the ends of a bounded interval.
+    */
+    struct fp_interval {
+        fp_encl m_l;
+        fp_encl m_u;
+    };
+
+    /**
+       \brief Return false if the new bound for z, whose value is in e, cannot improve the current one at node n.
+    */
+    bool fp_may_improve(var z, fp_encl const & e, bool lower, node * n);
+
+    /**
+       \brief Store in r the enclosure of a. Return false if a is not a small rational.
+    */
+    bool fp_enclose(numeral const & a, fp_encl & r);
+
+    /**
+       \brief Store in r the enclosures of the bounds of x at node n. Return false if x is unbounded
+       on some side or one of its bounds is not a small rational.
+    */
+    bool fp_enclose(var x, node * n, fp_interval & r);
+
+    /**
+       \brief Interval operations on enclosures, they mirror the exact ones of the interval manager.
+       Return false if the signs needed to pick the ends are not known or a result overflows.
+    */
+    static bool fp_mul(fp_encl const & a, fp_encl const & b, fp_encl & r);
+    static bool fp_div(fp_encl const & a, fp_encl const & b, fp_encl & r);
+    static bool fp_mul(fp_interval const & a, fp_interval const & b, fp_interval & r);
+    static bool fp_div(fp_interval const & a, fp_interval const & b, fp_interval & r);
+    static bool fp_power(fp_interval const & a, unsigned d, fp_interval & r);
+
+    /**
+       \brief Return false if double precision arithmetic shows that propagate_monomial_upward
+       (resp. propagate_monomial_downward for the j-th variable) cannot produce a new bound at node n.
+       Return true whenever the answer is not known.
+       \pre is_monomial(x)
+    */
+    bool may_improve_monomial_upward(var x, node * n);
+    bool may_improve_monomial_downward(var x, node * n, unsigned j);
+
+    /**
+       \brief Return false if double precision arithmetic shows that the polynomial associated with x
+       cannot produce a relevant new bound at node n. The rounding errors are bounded, so the answer is sound.
+       Return true whenever some coefficient or bound is not a small rational.
+       \pre is_polynomial(x)
+    */
+    bool may_improve_polynomial(var x, node * n);
 
     /**
        \brief Propagate new bounds at node n using clause c.
+       Watched atoms that are false at n are replaced by non-false ones when possible.
     */
     void propagate_clause(clause * c, node * n);
+
+    /**
+       \brief Return true if one of the watched atoms of c is an atom on x.
+    */
+    bool watches_var(clause * c, var x) const;
+
+    void add_clause_watches(clause * c);
+
+    /**
+       \brief Make the i-th atom of c the watch at the given slot.
+    */
+    void set_watch(clause * c, unsigned slot, unsigned i);
+
+    /**
+       \brief Similar to set_watch, but records the move in the watch trail of n.
+    */
+    void move_watch(clause * c, unsigned slot, unsigned i, node * n);
+
+    void undo_watches(node * n);
+    void redo_watches(node * n);
+
+    /**
+       \brief Update the clause watches to reflect the state of node n.
+       Only the moves between n and its lowest common ancestor with m_watch_node are undone/replayed.
+    */
+    void switch_watches(node * n);
+
+    /**
+       \brief Rebuild m_clause_wlist from scratch, removing stale and duplicate entries.
+    */
+    void rebuild_clause_watches();
+
+    /**
+       \brief Visit all clauses at the root node, and select watches that are not false there.
+    */
+    void init_clause_watches(node * n);
+
+    /**
+       \brief Propagate the clauses watching an atom on x at node n.
+    */
+    void propagate_clause_watches(var x, node * n);
+
+    /**
+       \brief Propagate at node n the clauses watching the variables of the bounds that
+       the propagation of its parent did not process. Their watched atoms may be false at n.
+    */
+    void propagate_pending_watches(node * n);
     
     /**
        \brief Return the truth value of atom t at node n.
@@ -1087,6 +1399,17 @@ private:
        \brief Perform bound propagation at node n.
     */
     void propagate(node * n);
+
+    /**
+       \brief Amount of work performed by propagation so far: bounds processed,
+       watch entries visited and bounds created.
+    */
+    unsigned prop_work() const { return m_curr_propagate + m_num_visited + m_num_mk_bounds; }
+
+    /**
+       \brief Time budget (in milliseconds) for propagating node n.
+    */
+    unsigned prop_budget_ms(node * n) const;
     
     /**
        \brief Try to propagate at node n using all definitions.
@@ -1115,14 +1438,99 @@ private:
     
     bool test_dominated(vector<lit> & longer_cla, vector<lit> & shorter_cla);
 
+    /**
+       \brief Index of the (variable, literal kind) pair of l.
+       A literal can only match literals with the same key in test_dominated.
+    */
+    static unsigned lit_key(lit const & l) { return 6 * l.m_x + 2 * l.get_type() + l.m_lower; }
+
+    /**
+       \brief 64-bit signature of a clause. If a clause dominates another one,
+       its signature is a subset of the signature of the other clause.
+    */
+    static uint64_t clause_signature(vector<lit> const & cla);
+
     void remove_dominated_clauses(vector<vector<lit>> & input, vector<vector<lit>> & output);
     
     bool simplify_ineqs_in_clause(vector<lit> & input, vector<lit> & output, bool is_conjunction);
 
     // void convert_node_task_to_task(node * n);
 
+    /**
+       \brief Store the task of node n in m_ptask. Return true if n is unsat.
+       If the parent of n has a residual clause set, only its clauses are processed, and only
+       the atoms on variables whose bounds changed in n are evaluated again.
+    */
     bool convert_node_to_task(node * n);
 
+    bool convert_node_to_task_core(node * n, unsigned_vector const * parent_residual);
+
+    /**
+       \brief Return true if the linear relaxation of node n is infeasible.
+       The relaxation consists of the polynomial definitions, the McCormick
+       inequalities of the bilinear and square monomials, and the bounds of n.
+       Clauses are not part of it.
+    */
+    bool refute_relaxation(node * n);
+
+    unsigned lp_var(node * n, var x);
+
+    /**
+       \brief Add the row s = x - a*y - b*z with the bound s >= c (lower) or s <= c to the relaxation.
+    */
+    void add_lp_envelope(node * n, var x, numeral const & a, var y, numeral const & b, var z,
+                         numeral const & c, bool lower);
+
+    /**
+       \brief Search a point of the box of node n satisfying the definitions and the clauses:
+       the simplest point of the box is improved by a local search that moves one variable of a
+       violated constraint at a time. At most budget points are evaluated. The point is stored in m_model.
+    */
+    bool find_model(node * n, unsigned budget);
+
+    /**
+       \brief Return 0 if v is a value of the box of x at node n, a positive distance to it otherwise.
+    */
+    double box_distance(node * n, var x, numeral const & v) const;
+
+    /**
+       \brief Store in m_model[x] a value of the box of n, the simplest one if simple is true,
+       a random one otherwise. Return false if the box of x has no value of its type.
+    */
+    bool sample_value(node * n, var x, bool simple);
+
+    /**
+       \brief Return 0 if atom a is true at m_model, a positive distance to its truth otherwise.
+    */
+    double atom_distance(atom * a) const;
+
+    /**
+       \brief Evaluate the definitions at m_model and return the number of violated bounds
+       and clauses, dist is the sum of their distances. Store in culprit a variable (not a
+       definition) of a random violated one.
+    */
+    unsigned num_violations(node * n, var & culprit, double & dist);
+
+    var pick_input_var(var x);
+
+    /**
+       \brief Release the residual clause set of n if none of its children needs it anymore.
+    */
+    void release_task_residual(node * n);
+
+    /**
+       \brief Mark the variables whose bounds at n differ from the ones at its ancestor p.
+    */
+    void mark_changed_vars(node * n, node * p);
+
+    void unmark_changed_vars();
+
+    /**
+       \brief Return true if x was marked by mark_changed_vars. An atom without a variable
+       is always evaluated.
+    */
+    bool is_changed_var(var x) const { return x == null_var || m_changed_var[x]; }
+
     void convert_root_to_task();
     
     /**
@@ -1131,8 +1539,179 @@ private:
     void collect_task_var_info();
     
     void select_best_var(node * n);
+
+    /**
+       \brief Compute the split heuristic information of x at node n.
+       Return false if x cannot be split.
+    */
+    bool calc_var_info(node * n, var x, var_info & info);
+
+    void collect_split_lits(var x, vector<lit> & x_lits);
+
+    /**
+       \brief Select the bound (mid, blower, bopen) splitting x at node n.
+       The left child gets this bound and the right child its negation.
+    */
+    void select_split_bound(node * n, var x, bool cz, vector<lit> & x_lits, numeral & mid, bool & blower, bool & bopen);
+
+    void add_lookahead_var(var x, double score);
+
+    /**
+       \brief Number of literals of the task of the parent of c that are removed at c.
+    */
+    unsigned count_reduced_lits(node * c);
+
+    /**
+       \brief Estimate the size of the task of c, a child of the node being split,
+       from the task residual of its parent. Store the features of c in m_node_features.
+    */
+    void estimate_task(node * c, unsigned & undef_clauses, unsigned & undef_lits);
+
+    /**
+       \brief Degree of x: 1 for a variable, the total degree of a monomial definition,
+       or the maximal degree of the monomials of a polynomial definition.
+    */
+    unsigned var_degree(var x);
+
+    /**
+       \brief Add the leaf c to the heap of nodes to be converted into tasks.
+    */
+    void push_leaf(node * c);
+
+    /**
+       \brief Update the cost model with the solving time of node id reported by the coordinator.
+    */
+    void observe_solving_time(unsigned id, double time, bool completed);
+
+    /**
+       \brief Create a temporary child of n with the given bound on x, propagate it,
+       and return 1 + the number of literals it removes (or 1 + all literals on a conflict).
+    */
+    double lookahead_side(node * n, var x, numeral const & mid, bool lower, bool open);
+
+    /**
+       \brief Tentatively split n on its best candidates and select the one
+       simplifying both children the most.
+    */
+    void lookahead(node * n);
+
+    void need_lemma_bounds(var x);
+
+    /**
+       \brief Add the bounds on the variables of the constraint justifying b
+       to the bounds needed by the conflict analysis.
+    */
+    void need_jst_bounds(bound * b);
+
+    /**
+       \brief Learn a lemma from the inconsistent node n.
+       The lemma is the negation of the split bounds the conflict depends on,
+       bounds at the root are consequences of the input constraints.
+    */
+    void learn_lemma(node * n);
+
+    /**
+       \brief Propagate the lemmas learned after the parent of n was propagated.
+    */
+    void propagate_new_lemmas(node * n);
+
+    void set_node_state(unsigned id, node_state sta);
+
+    /**
+       \brief Free the bound arrays of a terminated node. Its trail, watch moves and
+       split variables are kept, since they are still used by its descendants.
+    */
+    void release_node_data(node * n);
+
+    /**
+       \brief Delete the UNSAT subtree rooted at n. The ids of its nodes are not reused.
+    */
+    void del_subtree(node * n);
+
+    /**
+       \brief Reclaim the memory of the nodes in m_gc_candidates.
+    */
+    void collect_garbage();
+
+    /**
+       \brief Add the clause given by m_temp_atom_buffer (undefined atoms at the node) to a task.
+    */
+    void add_task_clause(task_info & task, vector<lit> & temp_units, vector<vector<lit>> & temp_clauses);
     
     void split_node(node * n);
+    void split_node_core(node * n);
+
+    /**
+       \brief Create the children of n for the split bound of x given by mid, lower and open
+       (the left child gets the bound, the right child its negation), and propagate them.
+    */
+    void split_node_at(node * n, var x, numeral const & mid, bool lower, bool open);
+
+    void journal(journal_record const & r);
+
+    /**
+       \brief Hash of the variables, their definitions, the unit and non-unit clauses (including
+       the values of the atoms) and of the random seed, a journal is only replayed on the same input.
+    */
+    uint64_t input_fingerprint() const;
+
+    /**
+       \brief Replay the journal given by partition_restore and start the one given by partition_snapshot.
+    */
+    void init_journal();
+
+    /**
+       \brief Rebuild the tree from the records of a journal. The bounds of the nodes are
+       recomputed by propagation, the split choices and the random generator are restored.
+    */
+    void replay_journal(std::vector<journal_record> const & records);
+
+    /**
+       \brief Name of x that does not depend on the numbering of the variables.
+    */
+    std::string var_name(var x) const;
+
+    /**
+       \brief Write the subtree rooted at node id to path, in terms of variable names:
+
+           split <parent> <first> <second> <lower> <open> <value> <var name>
+           unsat <node>
+
+       The subtree nodes are numbered from 0 (node id). Unsat nodes (including the
+       collected ones) are not descended into, the other leaves are the pending ones.
+    */
+    void export_subtree(unsigned id, std::string const & path);
+
+    /**
+       \brief Import the subtree given by partition_import, written by another partitioner
+       for the node whose task is the input of this one. The nodes are split with the
+       imported splits, and the children known to be unsat are not converted to tasks.
+    */
+    void import_subtree();
+
+    void attach_import(unsigned sub_id, node * n);
+
+    /**
+       \brief Assert the root bounds saved in m_root_cache, return false if there are none.
+       The file is keyed by the preprocessed goal, whose variables are numbered the same
+       way in every process. After the line "; root bounds <number of variables>",
+       there is a bound of a variable that is not a definition per line:
+
+           lower <open> <value> <var>
+           upper <open> <value> <var>
+           bool <value> <var>
+    */
+    bool load_root_bounds();
+
+    /**
+       \brief Save the bounds of the propagated root to m_root_cache.
+    */
+    void save_root_bounds();
+
+    /**
+       \brief Split n with its imported split, return false if it has none.
+    */
+    bool split_imported_node(node * n);
 
     void write_ss_line_to_coordinator();
     
@@ -1144,6 +1723,10 @@ private:
 
     bool read_line_from_coordinator();
 
+    void flush_lines_to_coordinator();
+
+    void wait_for_coordinator(unsigned ms);
+
     bool update_node_state_unsat(unsigned id);
 
     void unsat_push_down(node * n);
@@ -1170,6 +1753,12 @@ private:
     
     bool create_new_task();
 
+    /**
+       \brief Notify the coordinator that node id (child of pid) is a new task,
+       with its predicted difficulty when a cost model is used.
+    */
+    void write_unknown_node_line(unsigned id, int pid);
+
     // -----------------------------------
     //
     // Debugging support
@@ -1275,6 +1864,17 @@ public:
 
     void set_task_ptr(task_info * p) { m_ptask = p; }
 
+    void set_models_enabled(bool f) { m_models_enabled = f; }
+
+    void set_root_cache(std::string const & path) { m_root_cache = path; }
+
+    /**
+       \brief Return true if the last call of operator() found a model, the value of x is model_value(x).
+    */
+    bool found_model() const { return m_found_model; }
+
+    numeral const & model_value(var x) const { return m_model[x]; }
+
     void updt_params(params_ref const & p);
 
     static void collect_param_descrs(param_descrs & d);
@@ -26,8 +26,13 @@ Revision History:
 #include "util/gparams.h"
 
 #include <memory>
+#include <unordered_map>
+#include <cmath>
 #include <thread>
+#include <chrono>
+#include <cstdio>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -148,6 +153,11 @@ context_t::node::node(context_t & s, unsigned id, bool_vector &is_bool):
     m_next_sibling    = nullptr;
     m_prev            = nullptr;
     m_next            = nullptr;
+    m_num_lemmas      = 0;
+    m_num_unit_lemmas = 0;
+    m_split_var       = null_var;
+    m_up_atoms        = nullptr;
+    m_parent_up_atoms = nullptr;
     bm().mk(m_lowers);
     bm().mk(m_uppers);
     for (unsigned i = 0; i < num_vars; i++) {
@@ -176,9 +186,14 @@ context_t::node::node(node * parent, unsigned id):
     m_next_sibling   = parent->m_first_child;
     m_prev           = nullptr;
     m_next           = nullptr;
+    m_num_lemmas     = 0;
+    m_num_unit_lemmas = 0;
+    m_split_var      = null_var;
+    m_up_atoms       = parent->m_up_atoms;
+    m_parent_up_atoms = parent->m_up_atoms;
+    for (unsigned i = 0; i < num_keys; ++i)
+        m_key_rank[i] = parent->m_key_rank[i];
     parent->m_first_child = this;
-
-    m_up_atoms.append(parent->m_up_atoms.size(), parent->m_up_atoms.data());
 }
 
 /**
@@ -284,7 +299,10 @@ context_t::context_t(reslimit& lim, config_mpq const & c, params_ref const & p,
     m_curr_var_info(nm()),
     m_root_bicp_done(false),
     m_im(lim, interval_config(m_c.m())),
-    m_num_buffer(nm())
+    m_num_buffer(nm()),
+    m_term_lowers(nm()),
+    m_term_uppers(nm()),
+    m_model(nm())
 {
     m_parti_debug = false;
     //#linxi debug
@@ -298,6 +316,14 @@ context_t::context_t(reslimit& lim, config_mpq const & c, params_ref const & p,
     m_conflict      = null_var;
     m_qhead         = 0;
     m_display_proc  = &m_default_display_proc;
+    m_watch_node    = nullptr;
+    m_num_watch_pushes = 0;
+    m_replaying     = false;
+    m_fp_filter     = false;
+    m_hardness_model = nullptr;
+    m_lp_refuter    = nullptr;
+    m_models_enabled = false;
+    m_found_model   = false;
 
     m_num_nodes     = 0;
     updt_params(p);
@@ -321,6 +347,10 @@ context_t::~context_t() {
     nm().del(m_tmp1);
     nm().del(m_tmp2);
     nm().del(m_tmp3);
+    nm().del(m_sum_lower);
+    nm().del(m_sum_upper);
+    nm().del(m_term_bound);
+    nm().del(m_lookahead_mid);
     nm().del(m_ztmp1);
     del(m_i_tmp1);
     del(m_i_tmp2);
@@ -329,6 +359,10 @@ context_t::~context_t() {
     del_unit_clauses();
     del_clauses();
     del_definitions();
+    if (m_hardness_model != nullptr)
+        dealloc(m_hardness_model);
+    if (m_lp_refuter != nullptr)
+        dealloc(m_lp_refuter);
     if (m_own_allocator)
         dealloc(m_allocator);
 }
@@ -632,6 +666,7 @@ var context_t::mk_var(bool is_int) {
     m_is_bool.push_back(false);
     m_defs.push_back(0);
     m_wlist.push_back(watch_list());
+    m_clause_wlist.push_back(clause_watch_list());
     return r;
 }
 
@@ -641,6 +676,7 @@ var context_t::mk_bvar() {
     m_is_bool.push_back(true);
     m_defs.push_back(0);
     m_wlist.push_back(watch_list());
+    m_clause_wlist.push_back(clause_watch_list());
     return r;
 }
 
@@ -783,13 +819,10 @@ void context_t::add_clause_core(unsigned sz, atom * const * atoms, bool lemma, b
         c->m_atoms[i] = atoms[i];
     }
     std::stable_sort(c->m_atoms, c->m_atoms + sz, typename atom::lt_var_proc());
-    if (watch) {
-        for (unsigned i = 0; i < sz; i++) {
-            var x = c->m_atoms[i]->x();
-            if (x != null_var && (i == 0 || x != c->m_atoms[i-1]->x()))
-                m_wlist[x].push_back(watched(c));
-        }
-    }
+    c->m_watch[0] = 0;
+    c->m_watch[1] = 1;
+    if (watch)
+        add_clause_watches(c);
     c->m_lemma   = lemma;
     c->m_num_jst = 0;
     c->m_watched = watch;
@@ -811,8 +844,15 @@ void context_t::del_clause(clause * c) {
     for (unsigned i = 0; i < sz; i++) {
         var x = c->m_atoms[i]->x();
         if (watch) {
-            if (x != prev_x)
-                m_wlist[x].erase(watched(c));
+            if (x != prev_x && x != null_var) {
+                // remove c and its stale entries from the watch list of x
+                clause_watch_list & wl = m_clause_wlist[x];
+                unsigned j = 0;
+                for (unsigned k = 0; k < wl.size(); k++)
+                    if (wl[k] != c)
+                        wl[j++] = wl[k];
+                wl.shrink(j);
+            }
             prev_x = x;
         }
         dec_ref((*c)[i]);
@@ -838,26 +878,17 @@ typename context_t::node * context_t::mk_node(node * parent) {
     void * mem = allocator().allocate(sizeof(node));
     node * r;
     if (parent == nullptr) {
-        r = new (mem) node(*this, m_num_nodes, m_is_bool);
-        if (m_rand_seed != 1) {
-            r->key_rank().push_back(0);
-            r->key_rank().push_back(1);
-            r->key_rank().push_back(3);
-            r->key_rank().push_back(2);
-            r->key_rank().push_back(4);
-            // for (unsigned i = 0; i < m_var_key_num; ++i)
-            //     r->key_rank().push_back(i);
-        }
-        else {
-            r->key_rank().push_back(0);
-            r->key_rank().push_back(3);
-            r->key_rank().push_back(1);
-            r->key_rank().push_back(2);
-            r->key_rank().push_back(4);
-        }
+        r = new (mem) node(*this, m_nodes.size(), m_is_bool);
+        static const unsigned default_rank[node::num_keys] = {0, 1, 3, 2, 4};
+        static const unsigned seed1_rank[node::num_keys] = {0, 3, 1, 2, 4};
+        unsigned const * rank = m_rand_seed != 1 ? default_rank : seed1_rank;
+        for (unsigned i = 0; i < node::num_keys; ++i)
+            r->key_rank()[i] = rank[i];
+        // for (unsigned i = 0; i < m_var_key_num; ++i)
+        //     r->key_rank()[i] = i;
     }
     else {
-        r = new (mem) node(parent, m_num_nodes);
+        r = new (mem) node(parent, m_nodes.size());
         // dynamic key rank
         // unsigned pos = 0;
         // for (unsigned i = 0; i < m_var_key_num; ++i) {
@@ -872,12 +903,7 @@ typename context_t::node * context_t::mk_node(node * parent) {
         // else {
         //     std::swap(r->key_rank()[pos - 1], r->key_rank()[pos]);
         // }
-        // static key rank
-        for (unsigned i = 0; i < m_var_key_num; ++i)
-            r->key_rank().push_back(parent->key_rank()[i]);
-        
-        for (unsigned i = 0, sz = parent->depth(); i < sz; ++i)
-            r->split_vars().push_back(parent->split_vars()[i]);
+        // static key rank: copied from the parent by the node constructor
     }
 
     // Add node in the leaf dlist
@@ -926,12 +952,43 @@ void context_t::del_node(node * n) {
         b = b->prev();
         del_bound(old);
     }
+    if (m_watch_node == n) {
+        undo_watches(n);
+        m_watch_node = p;
+    }
+    del_up_atoms(n);
     bm().del(n->uppers());
     bm().del(n->lowers());
+    bvm().del(n->bvalues());
+    unsigned id = n->id();
+    if (id < m_task_residuals.size()) {
+        m_task_residual_valid[id] = false;
+        m_task_residuals[id].finalize();
+    }
     n->~node();
     allocator().deallocate(sizeof(node), n);
 }
 
+void context_t::push_up_atom(node * n, atom * a) {
+    up_atom_cell * c = static_cast<up_atom_cell*>(allocator().allocate(sizeof(up_atom_cell)));
+    c->m_atom = a;
+    c->m_next = n->up_atoms();
+    n->push_up_atom(c);
+}
+
+/**
+   \brief Release the up atom cells owned by n, the cells of its ancestors are kept.
+*/
+void context_t::del_up_atoms(node * n) {
+    up_atom_cell * c = n->up_atoms();
+    up_atom_cell * c_old = n->parent_up_atoms();
+    while (c != c_old) {
+        up_atom_cell * next = c->m_next;
+        allocator().deallocate(sizeof(up_atom_cell), c);
+        c = next;
+    }
+}
+
 void context_t::del_nodes() {
     ptr_buffer<node> todo;
     if (m_root == nullptr)
@@ -1076,6 +1133,9 @@ void context_t::del_unit_clauses() {
     for (unsigned i = 0; i < sz; i++)
         dec_ref(UNTAG(atom*, m_unit_clauses[i]));
     m_unit_clauses.reset();
+    for (atom * a : m_unit_lemmas)
+        dec_ref(a);
+    m_unit_lemmas.reset();
 }
 
 void context_t::del_clauses(ptr_vector<clause> & cs) {
@@ -1710,45 +1770,183 @@ lbool context_t::value(lit & tl, node * n) {
     }
 }
 
+bool context_t::watches_var(clause * c, var x) const {
+    return c->m_atoms[c->m_watch[0]]->x() == x || c->m_atoms[c->m_watch[1]]->x() == x;
+}
+
+void context_t::add_clause_watches(clause * c) {
+    var x0 = c->m_atoms[c->m_watch[0]]->x();
+    var x1 = c->m_atoms[c->m_watch[1]]->x();
+    if (x0 != null_var)
+        m_clause_wlist[x0].push_back(c);
+    if (x1 != null_var && x1 != x0)
+        m_clause_wlist[x1].push_back(c);
+}
+
+void context_t::set_watch(clause * c, unsigned slot, unsigned i) {
+    unsigned old = c->m_watch[slot];
+    c->m_watch[slot] = i;
+    var x = c->m_atoms[i]->x();
+    // c is already in the watch lists of the variables of the other watch and the old watch.
+    if (x != null_var && x != c->m_atoms[old]->x() && x != c->m_atoms[c->m_watch[1 - slot]]->x()) {
+        m_clause_wlist[x].push_back(c);
+        m_num_watch_pushes++;
+    }
+}
+
+void context_t::move_watch(clause * c, unsigned slot, unsigned i, node * n) {
+    SASSERT(m_watch_node == n);
+    // Moves at the root are never undone, since the root is an ancestor of every node.
+    if (n != m_root)
+        n->watch_trail().push_back(watch_move(c, slot, c->m_watch[slot], i));
+    set_watch(c, slot, i);
+    m_num_watch_moves++;
+}
+
+void context_t::undo_watches(node * n) {
+    svector<watch_move> const & trail = n->watch_trail();
+    unsigned i = trail.size();
+    while (i > 0) {
+        --i;
+        watch_move const & m = trail[i];
+        SASSERT(m.m_clause->m_watch[m.m_slot] == m.m_new);
+        set_watch(m.m_clause, m.m_slot, m.m_old);
+    }
+}
+
+void context_t::redo_watches(node * n) {
+    for (watch_move const & m : n->watch_trail()) {
+        SASSERT(m.m_clause->m_watch[m.m_slot] == m.m_old);
+        set_watch(m.m_clause, m.m_slot, m.m_new);
+    }
+}
+
+void context_t::switch_watches(node * n) {
+    SASSERT(m_watch_node != nullptr);
+    ptr_buffer<node> todo;
+    node * curr   = m_watch_node;
+    node * target = n;
+    while (curr != target) {
+        if (curr->depth() >= target->depth()) {
+            undo_watches(curr);
+            curr = curr->parent();
+        }
+        else {
+            todo.push_back(target);
+            target = target->parent();
+        }
+    }
+    while (!todo.empty()) {
+        redo_watches(todo.back());
+        todo.pop_back();
+    }
+    m_watch_node = n;
+    if (m_num_watch_pushes > 2 * (m_clauses.size() + m_lemmas.size()))
+        rebuild_clause_watches();
+}
+
+void context_t::rebuild_clause_watches() {
+    for (clause_watch_list & wl : m_clause_wlist)
+        wl.reset();
+    for (clause * c : m_clauses)
+        add_clause_watches(c);
+    for (clause * c : m_lemmas)
+        add_clause_watches(c);
+    m_num_watch_pushes = 0;
+}
+
+void context_t::init_clause_watches(node * n) {
+    SASSERT(n == m_root);
+    m_watch_node = n;
+    for (unsigned k = 0; k < 2; k++) {
+        ptr_vector<clause> const & cs = k == 0 ? m_clauses : m_lemmas;
+        for (clause * c : cs) {
+            if (inconsistent(n))
+                return;
+            try {
+                propagate_clause(c, n);
+            }
+            catch (const typename config_mpq::exception &) {
+                // arithmetic module failed, ignore constraint
+                set_arith_failed();
+            }
+        }
+    }
+}
+
+void context_t::propagate_clause_watches(var x, node * n) {
+    clause_watch_list & wl = m_clause_wlist[x];
+    unsigned sz = wl.size();
+    unsigned j  = 0;
+    for (unsigned i = 0; i < sz; i++) {
+        clause * c = wl[i];
+        if (!watches_var(c, x))
+            continue; // stale entry
+        if (!inconsistent(n)) {
+            try {
+                propagate_clause(c, n);
+            }
+            catch (const typename config_mpq::exception &) {
+                // arithmetic module failed, ignore constraint
+                set_arith_failed();
+            }
+        }
+        if (watches_var(c, x))
+            wl[j++] = c;
+    }
+    // a clause in this list always keeps a watch on x or moves it to another variable
+    SASSERT(wl.size() == sz);
+    wl.shrink(j);
+}
+
+void context_t::propagate_pending_watches(node * n) {
+    svector<var> & xs = n->parent()->pending_watch_vars();
+    for (unsigned i = 0; i < xs.size() && !inconsistent(n); i++)
+        propagate_clause_watches(xs[i], n);
+}
+
 void context_t::propagate_clause(clause * c, node * n) {
     TRACE("propagate_clause", tout << "propagate using:\n"; display(tout, c); tout << "\n";);
     m_num_visited++;
-    c->set_visited(m_timestamp);
+    unsigned * w = c->m_watch;
+    lbool v0 = value((*c)[w[0]], n);
+    if (v0 == l_true)
+        return; // clause was already satisfied at n
+    lbool v1 = value((*c)[w[1]], n);
+    if (v1 == l_true)
+        return;
+    if (v0 != l_false && v1 != l_false)
+        return; // clause has two unassigned watched atoms
     unsigned sz = c->size();
-    unsigned j  = UINT_MAX;
-    // {
-    //     m_temp_stringstream << "propagate_clause: ";
-    //     display(m_temp_stringstream, c);
-    //     write_debug_ss_line_to_coordinator();
-    //     for (unsigned i = 0; i < sz; i++) {
-    //         atom * at = (*c)[i];
-    //         m_temp_stringstream << " l[" << i << "] = " << value(at, n);
-    //     }
-    //     write_debug_ss_line_to_coordinator();
-    // }
-    for (unsigned i = 0; i < sz; i++) {
-        atom * at = (*c)[i];
+    for (unsigned i = 0; i < sz && (v0 == l_false || v1 == l_false); i++) {
+        if (i == w[0] || i == w[1])
+            continue;
+        lbool v = value((*c)[i], n);
         TRACE("linxi_subpaving",
-            tout << "l[" << i << "] = " << value(at, n) << "\n";
+            tout << "l[" << i << "] = " << v << "\n";
         );
-        switch (value(at, n)) {
-        case l_true:
-            return; // clause was already satisfied at n
-        case l_false:
-            break;
-        case l_undef:
-            if (j != UINT_MAX)
-                return; // clause has more than one unassigned literal
-            j = i;
-            break;
-        }
+        if (v == l_false)
+            continue;
+        unsigned slot = v0 == l_false ? 0 : 1;
+        move_watch(c, slot, i, n);
+        if (v == l_true)
+            return;
+        if (slot == 0)
+            v0 = v;
+        else
+            v1 = v;
     }
-    if (j == UINT_MAX) {
-        // Clause is in conflict, use first atom to trigger inconsistency
-        j = 0;
+    unsigned j;
+    if (v0 == l_false && v1 == l_false) {
+        // Clause is in conflict, use first watched atom to trigger inconsistency
+        j = w[0];
+    }
+    else if (v0 == l_false || v1 == l_false) {
+        j = v0 == l_false ? w[1] : w[0];
+        push_up_atom(n, (*c)[j]);
     }
     else {
-        n->up_atoms().push_back((*c)[j]);
+        return; // clause has more than one unassigned literal
     }
     atom * a = (*c)[j];
     TRACE("propagate_clause", tout << "propagating inequality: "; display(tout, a); tout << "\n";);
@@ -1768,74 +1966,274 @@ void context_t::propagate_clause(clause * c, node * n) {
     else {
         propagate_bound(a->x(), a->value(), a->is_lower(), a->is_open(), n, justification(c));
     }
-    // A clause can propagate only once.
-    // So, we can safely set its timestamp again to avoid another useless visit.
-    c->set_visited(m_timestamp);
 }
 
-void context_t::propagate_polynomial(var x, node * n, var y) {
-    SASSERT(y != null_var);
+void context_t::propagate_polynomial_bound(var x, node * n, var y, numeral const & val, bool lower, bool open) {
+    TRACE("propagate_polynomial_bug", tout << "y: "; display(tout, y); tout << (lower ? " >= " : " <= "); nm().display(tout, val); tout << ", open: " << open << "\n";);
+    if (relevant_new_bound(y, val, lower, open, n))
+        propagate_bound(y, val, lower, open, n, justification(x));
+}
+
+bool context_t::approx(numeral const & a, double & r) {
+    if (!nm().is_small(a))
+        return false;
+    r = nm().get_double(a);
+    return true;
+}
+
+bool context_t::fp_may_improve(var z, double v, double err, bool lower, node * n) {
+    bound * b = lower ? n->lower(z) : n->upper(z);
+    double c;
+    if (b == nullptr || !approx(b->value(), c))
+        return true;
+    double c_err = std::fabs(c) * std::ldexp(1.0, -52);
+    // We only reject new bounds that are strictly worse than the current one.
+    if (lower)
+        return !(v + err < c - c_err);
+    else
+        return !(v - err > c + c_err);
+}
+
+bool context_t::fp_may_improve(var z, fp_encl const & e, bool lower, node * n) {
+    bound * b = lower ? n->lower(z) : n->upper(z);
+    double c;
+    if (b == nullptr || !approx(b->value(), c))
+        return true;
+    double c_err = std::fabs(c) * std::ldexp(1.0, -52);
+    if (lower)
+        return !(e.m_hi < c - c_err);
+    else
+        return !(e.m_lo > c + c_err);
+}
+
+bool context_t::fp_enclose(numeral const & a, fp_encl & r) {
+    double v;
+    if (!approx(a, v))
+        return false;
+    // small integers are exact doubles, the quotient of a small rational is correctly rounded
+    if (nm().is_int(a)) {
+        r.m_lo = v;
+        r.m_hi = v;
+    }
+    else {
+        r.m_lo = std::nextafter(v, -HUGE_VAL);
+        r.m_hi = std::nextafter(v, HUGE_VAL);
+    }
+    return true;
+}
+
+bool context_t::fp_enclose(var x, node * n, fp_interval & r) {
+    bound * l = n->lower(x);
+    bound * u = n->upper(x);
+    return l != nullptr && u != nullptr && fp_enclose(l->value(), r.m_l) && fp_enclose(u->value(), r.m_u);
+}
+
+bool context_t::fp_mul(fp_encl const & a, fp_encl const & b, fp_encl & r) {
+    // the extremes of x*y for x in a and y in b are products of ends,
+    // each product is correctly rounded and one step outwards encloses it.
+    double p[4] = { a.m_lo * b.m_lo, a.m_lo * b.m_hi, a.m_hi * b.m_lo, a.m_hi * b.m_hi };
+    r.m_lo = HUGE_VAL;
+    r.m_hi = -HUGE_VAL;
+    for (double v : p) {
+        if (!std::isfinite(v))
+            return false;
+        r.m_lo = std::min(r.m_lo, v == 0.0 ? 0.0 : std::nextafter(v, -HUGE_VAL));
+        r.m_hi = std::max(r.m_hi, v == 0.0 ? 0.0 : std::nextafter(v, HUGE_VAL));
+    }
+    return true;
+}
+
+bool context_t::fp_div(fp_encl const & a, fp_encl const & b, fp_encl & r) {
+    if (b.m_lo <= 0.0 && b.m_hi >= 0.0)
+        return false;
+    double q[4] = { a.m_lo / b.m_lo, a.m_lo / b.m_hi, a.m_hi / b.m_lo, a.m_hi / b.m_hi };
+    r.m_lo = HUGE_VAL;
+    r.m_hi = -HUGE_VAL;
+    for (double v : q) {
+        if (!std::isfinite(v))
+            return false;
+        r.m_lo = std::min(r.m_lo, v == 0.0 ? 0.0 : std::nextafter(v, -HUGE_VAL));
+        r.m_hi = std::max(r.m_hi, v == 0.0 ? 0.0 : std::nextafter(v, HUGE_VAL));
+    }
+    return true;
+}
+
+bool context_t::fp_mul(fp_interval const & a, fp_interval const & b, fp_interval & r) {
+    // the ends of the product are the minimum and maximum of the products of the ends
+    fp_encl p[4];
+    if (!fp_mul(a.m_l, b.m_l, p[0]) || !fp_mul(a.m_l, b.m_u, p[1]) ||
+        !fp_mul(a.m_u, b.m_l, p[2]) || !fp_mul(a.m_u, b.m_u, p[3]))
+        return false;
+    r.m_l = p[0];
+    r.m_u = p[0];
+    for (unsigned i = 1; i < 4; i++) {
+        r.m_l.m_lo = std::min(r.m_l.m_lo, p[i].m_lo);
+        r.m_l.m_hi = std::min(r.m_l.m_hi, p[i].m_hi);
+        r.m_u.m_lo = std::max(r.m_u.m_lo, p[i].m_lo);
+        r.m_u.m_hi = std::max(r.m_u.m_hi, p[i].m_hi);
+    }
+    return true;
+}
+
+bool context_t::fp_div(fp_interval const & a, fp_interval const & b, fp_interval & r) {
+    // b must not contain zero
+    if (!(b.m_l.m_lo > 0.0) && !(b.m_u.m_hi < 0.0))
+        return false;
+    fp_encl q[4];
+    if (!fp_div(a.m_l, b.m_l, q[0]) || !fp_div(a.m_l, b.m_u, q[1]) ||
+        !fp_div(a.m_u, b.m_l, q[2]) || !fp_div(a.m_u, b.m_u, q[3]))
+        return false;
+    r.m_l = q[0];
+    r.m_u = q[0];
+    for (unsigned i = 1; i < 4; i++) {
+        r.m_l.m_lo = std::min(r.m_l.m_lo, q[i].m_lo);
+        r.m_l.m_hi = std::min(r.m_l.m_hi, q[i].m_hi);
+        r.m_u.m_lo = std::max(r.m_u.m_lo, q[i].m_lo);
+        r.m_u.m_hi = std::max(r.m_u.m_hi, q[i].m_hi);
+    }
+    return true;
+}
+
+bool context_t::fp_power(fp_interval const & a, unsigned d, fp_interval & r) {
+    SASSERT(d > 0);
+    fp_encl l = a.m_l, u = a.m_u;
+    for (unsigned i = 1; i < d; i++) {
+        if (!fp_mul(l, a.m_l, l) || !fp_mul(u, a.m_u, u))
+            return false;
+    }
+    if (d % 2 == 1 || a.m_l.m_lo >= 0.0) {
+        // monotone
+        r.m_l = l;
+        r.m_u = u;
+    }
+    else if (a.m_u.m_hi <= 0.0) {
+        r.m_l = u;
+        r.m_u = l;
+    }
+    else if (a.m_l.m_hi < 0.0 && a.m_u.m_lo > 0.0) {
+        // [0, max(l^d, u^d)]
+        r.m_l.m_lo = 0.0;
+        r.m_l.m_hi = 0.0;
+        r.m_u.m_lo = std::max(l.m_lo, u.m_lo);
+        r.m_u.m_hi = std::max(l.m_hi, u.m_hi);
+    }
+    else {
+        return false; // the signs of the ends are not known
+    }
+    return true;
+}
+
+bool context_t::may_improve_monomial_upward(var x, node * n) {
+    SASSERT(is_monomial(x));
+    monomial * m = get_monomial(x);
+    fp_interval r, y, yk;
+    for (unsigned i = 0, sz = m->size(); i < sz; i++) {
+        if (!fp_enclose(m->x(i), n, y) || !fp_power(y, m->degree(i), yk))
+            return true;
+        if (i == 0)
+            r = yk;
+        else if (!fp_mul(r, yk, r))
+            return true;
+    }
+    return fp_may_improve(x, r.m_l, true, n) || fp_may_improve(x, r.m_u, false, n);
+}
+
+bool context_t::may_improve_monomial_downward(var x, node * n, unsigned j) {
+    SASSERT(is_monomial(x));
+    monomial * m = get_monomial(x);
+    if (m->degree(j) > 1)
+        return true;
+    fp_interval r, y, yk, d;
+    if (!fp_enclose(x, n, r))
+        return true;
+    bool first = true;
+    for (unsigned i = 0, sz = m->size(); i < sz; i++) {
+        if (i == j)
+            continue;
+        if (!fp_enclose(m->x(i), n, y) || !fp_power(y, m->degree(i), yk))
+            return true;
+        if (first)
+            d = yk;
+        else if (!fp_mul(d, yk, d))
+            return true;
+        first = false;
+    }
+    if (!first && !fp_div(r, d, r))
+        return true;
+    var z = m->x(j);
+    return fp_may_improve(z, r.m_l, true, n) || fp_may_improve(z, r.m_u, false, n);
+}
+
+bool context_t::may_improve_polynomial(var x, node * n) {
     SASSERT(is_polynomial(x));
-    TRACE("linxi_subpaving",
-        tout << "propagate_polynomial:\n";
-        tout << "x: "; display(tout, x); tout << "\n";
-        tout << "y: "; display(tout, y); tout << "\n";
-    );
+    // Same structure as propagate_polynomial, but using doubles.
     polynomial * p = get_polynomial(x);
-    unsigned sz    = p->size();
-    interval & r   = m_i_tmp1; r.set_mutable();
-    interval & v   = m_i_tmp2;
-    interval & av  = m_i_tmp3; av.set_mutable();
-    if (x == y) {
-        for (unsigned i = 0; i < sz; i++) {
-            var z = p->x(i);
-            v.set_constant(n, z);
-            im().mul(p->a(i), v, av);
-            if (i == 0)
-                im().set(r, av);
-            else
-                im().add(r, av, r);
+    unsigned sz  = p->size();
+    unsigned num = sz + 1;
+    m_approx_as.reset();
+    m_approx_lowers.reset();
+    m_approx_uppers.reset();
+    double sum_l = 0.0, sum_u = 0.0;
+    double mag_l = 0.0, mag_u = 0.0;
+    unsigned l_inf = 0, u_inf = 0;
+    for (unsigned i = 0; i < num; i++) {
+        double a = -1.0;
+        if (i < sz && !approx(p->a(i), a))
+            return true;
+        var z     = i < sz ? p->x(i) : x;
+        bool pos  = a > 0.0;
+        bound * l = pos ? n->lower(z) : n->upper(z);
+        bound * u = pos ? n->upper(z) : n->lower(z);
+        double lv = 0.0, uv = 0.0;
+        if (l == nullptr) {
+            l_inf++;
         }
-        // r contains the deduced bounds for x == y
-    }
-    else {
-        v.set_constant(n, x);
-        numeral & a = m_tmp1;
-        im().set(r, v);
-        for (unsigned i = 0; i < sz; i++) {
-            var z = p->x(i);
-            if (z != y) {
-                v.set_constant(n, z);
-                im().mul(p->a(i), v, av);
-                im().sub(r, av, r);
-            }
-            else {
-                nm().set(a, p->a(i));
-                TRACE("propagate_polynomial_bug", tout << "a: "; nm().display(tout, a); tout << "\n";);
-            }
+        else {
+            if (!approx(l->value(), lv))
+                return true;
+            lv *= a;
+            sum_l += lv;
+            mag_l += std::fabs(lv);
         }
-        TRACE("propagate_polynomial_bug", tout << "r before mul 1/a: "; im().display(tout, r); tout << "\n";);
-        im().div(r, a, r);
-        TRACE("propagate_polynomial_bug", tout << "r after mul 1/a:  "; im().display(tout, r); tout << "\n";);
-        // r contains the deduced bounds for y.
-    }
-    TRACE("linxi_subpaving",
-        tout << "interval: ";
-        im().display(tout, r);
-        tout << "\n"
-    );
-    // r contains the deduced bounds for y.
-    if (!r.m_l_inf) {
-        if (relevant_new_bound(y, r.m_l_val, true, r.m_l_open, n)) {
-            propagate_bound(y, r.m_l_val, true, r.m_l_open, n, justification(x));
-            if (inconsistent(n))
-                return;
+        if (u == nullptr) {
+            u_inf++;
+        }
+        else {
+            if (!approx(u->value(), uv))
+                return true;
+            uv *= a;
+            sum_u += uv;
+            mag_u += std::fabs(uv);
+        }
+        if (l_inf > 1 && u_inf > 1)
+            return false;
+        m_approx_as.push_back(a);
+        m_approx_lowers.push_back(lv);
+        m_approx_uppers.push_back(uv);
+    }
+    // Each operation has a relative error of at most 2^-53.
+    // gamma bounds (with slack) the error accumulated by the products, sums, subtraction and division.
+    double gamma = (num + 8) * std::ldexp(1.0, -52);
+    for (unsigned i = 0; i < num; i++) {
+        double a  = m_approx_as[i];
+        bool pos  = a > 0.0;
+        var z     = i < sz ? p->x(i) : x;
+        bound * l = pos ? n->lower(z) : n->upper(z);
+        bound * u = pos ? n->upper(z) : n->lower(z);
+        if (u_inf == 0 || (u_inf == 1 && u == nullptr)) {
+            double v   = (m_approx_uppers[i] - sum_u) / a;
+            double err = gamma * ((mag_u + std::fabs(m_approx_uppers[i])) / std::fabs(a) + std::fabs(v));
+            if (fp_may_improve(z, v, err, pos, n))
+                return true;
+        }
+        if (l_inf == 0 || (l_inf == 1 && l == nullptr)) {
+            double v   = (m_approx_lowers[i] - sum_l) / a;
+            double err = gamma * ((mag_l + std::fabs(m_approx_lowers[i])) / std::fabs(a) + std::fabs(v));
+            if (fp_may_improve(z, v, err, !pos, n))
+                return true;
         }
     }
-    if (!r.m_u_inf) {
-        if (relevant_new_bound(y, r.m_u_val, false, r.m_u_open, n))
-            propagate_bound(y, r.m_u_val, false, r.m_u_open, n, justification(x));
-    }
+    return false;
 }
 
 void context_t::propagate_polynomial(var x, node * n) {
@@ -1844,29 +2242,107 @@ void context_t::propagate_polynomial(var x, node * n) {
     SASSERT(is_polynomial(x));
     polynomial * p = get_polynomial(x);
     p->set_visited(m_timestamp);
-    var unbounded_var = null_var;
-    if (is_unbounded(x, n))
-        unbounded_var = x;
-    unsigned sz = p->size();
-    for (unsigned i = 0; i < sz; i++) {
-        var y = p->x(i);
-        if (is_unbounded(y, n)) {
-            if (unbounded_var != null_var)
-                return; // no propagation is possible.
-            unbounded_var = y;
-        }
-    }
-    TRACE("propagate_polynomial", tout << "unbounded_var: "; display(tout, unbounded_var); tout << "\n";);
-
-    if (unbounded_var != null_var) {
-        propagate_polynomial(x, n, unbounded_var);
+    if (m_fp_filter && !may_improve_polynomial(x, n)) {
+        m_num_fp_filtered++;
+        return;
     }
-    else {
-        propagate_polynomial(x, n, x);
-        for (unsigned i = 0; i < sz; i++) {
+    // x = a_0*z_0 + ... + a_{sz-1}*z_{sz-1} is viewed as the sum of the terms
+    // a_0*z_0, ..., a_{sz-1}*z_{sz-1}, -x, which must be equal to 0.
+    // The bounds of the whole sum are computed once, and the bounds of each term t
+    // are obtained by removing the contribution of t from it.
+    // Infinite and open ends are tracked by counting.
+    unsigned sz  = p->size();
+    unsigned num = sz + 1;
+    if (m_term_lowers.size() < num) {
+        m_term_lowers.resize(num);
+        m_term_uppers.resize(num);
+    }
+    m_term_lower_bounds.reset();
+    m_term_upper_bounds.reset();
+    numeral & sum_l = m_sum_lower;
+    numeral & sum_u = m_sum_upper;
+    nm().reset(sum_l);
+    nm().reset(sum_u);
+    unsigned l_inf = 0, u_inf = 0, l_open = 0, u_open = 0;
+    for (unsigned i = 0; i < num; i++) {
+        bool pos = i < sz && nm().is_pos(p->a(i));
+        var z    = i < sz ? p->x(i) : x;
+        bound * l = pos ? n->lower(z) : n->upper(z);
+        bound * u = pos ? n->upper(z) : n->lower(z);
+        m_term_lower_bounds.push_back(l);
+        m_term_upper_bounds.push_back(u);
+        if (l == nullptr) {
+            l_inf++;
+        }
+        else {
+            if (i < sz)
+                nm().mul(p->a(i), l->value(), m_term_lowers[i]);
+            else
+                nm().set(m_term_lowers[i], l->value());
+            if (i == sz)
+                nm().neg(m_term_lowers[i]);
+            nm().add(sum_l, m_term_lowers[i], sum_l);
+            if (l->is_open())
+                l_open++;
+        }
+        if (u == nullptr) {
+            u_inf++;
+        }
+        else {
+            if (i < sz)
+                nm().mul(p->a(i), u->value(), m_term_uppers[i]);
+            else
+                nm().set(m_term_uppers[i], u->value());
+            if (i == sz)
+                nm().neg(m_term_uppers[i]);
+            nm().add(sum_u, m_term_uppers[i], sum_u);
+            if (u->is_open())
+                u_open++;
+        }
+        if (l_inf > 1 && u_inf > 1)
+            return; // no propagation is possible.
+    }
+    TRACE("propagate_polynomial", tout << "l_inf: " << l_inf << ", u_inf: " << u_inf << "\n";);
+
+    numeral & val = m_term_bound;
+    // process x first
+    for (unsigned k = 0; k < num; k++) {
+        unsigned i = k == 0 ? sz : k - 1;
+        if (inconsistent(n))
+            return;
+        bool pos  = i < sz && nm().is_pos(p->a(i));
+        var z     = i < sz ? p->x(i) : x;
+        bound * l = m_term_lower_bounds[i];
+        bound * u = m_term_upper_bounds[i];
+        // lower(t) = -(upper of the other terms)
+        if (u_inf == 0 || (u_inf == 1 && u == nullptr)) {
+            if (u == nullptr)
+                nm().reset(val);
+            else
+                nm().set(val, m_term_uppers[i]);
+            nm().sub(val, sum_u, val);
+            bool open = u_open > ((u != nullptr && u->is_open()) ? 1u : 0u);
+            if (i < sz)
+                nm().div(val, p->a(i), val);
+            else
+                nm().neg(val);
+            propagate_polynomial_bound(x, n, z, val, pos, open);
             if (inconsistent(n))
                 return;
-            propagate_polynomial(x, n, p->x(i));
+        }
+        // upper(t) = -(lower of the other terms)
+        if (l_inf == 0 || (l_inf == 1 && l == nullptr)) {
+            if (l == nullptr)
+                nm().reset(val);
+            else
+                nm().set(val, m_term_lowers[i]);
+            nm().sub(val, sum_l, val);
+            bool open = l_open > ((l != nullptr && l->is_open()) ? 1u : 0u);
+            if (i < sz)
+                nm().div(val, p->a(i), val);
+            else
+                nm().neg(val);
+            propagate_polynomial_bound(x, n, z, val, !pos, open);
         }
     }
 }
@@ -1951,6 +2427,10 @@ void context_t::propagate_monomial(var x, node * n) {
 void context_t::propagate_monomial_upward(var x, node * n) {
     SASSERT(is_monomial(x));
     monomial * m = get_monomial(x);
+    if (m_fp_filter && !may_improve_monomial_upward(x, n)) {
+        m_num_fp_filtered++;
+        return;
+    }
     unsigned sz  = m->size();
     interval & r  = m_i_tmp1; r.set_mutable();
     interval & y  = m_i_tmp2;
@@ -1990,6 +2470,10 @@ void context_t::propagate_monomial_downward(var x, node * n, unsigned j) {
     SASSERT(j < m->size());
     unsigned sz = m->size();
 
+    if (m_fp_filter && !may_improve_monomial_downward(x, n, j)) {
+        m_num_fp_filtered++;
+        return;
+    }
     interval & r = m_i_tmp3;
     if (sz > 1) {
         interval & d  = m_i_tmp1; d.set_mutable();
@@ -2113,22 +2597,8 @@ void context_t::propagate_bvar(node * n, bound * b) {
     var x = b->x();
     TRACE("subpaving_propagate", tout << "propagate: "; display(tout, b); tout << ", timestamp: " << b->timestamp() << "\n";);
     ++m_curr_propagate;
-    typename watch_list::const_iterator it  = m_wlist[x].begin();
-    typename watch_list::const_iterator end = m_wlist[x].end();
-    for (; it != end; ++it) {
-        if (inconsistent(n))
-            return;
-        watched const & w = *it;
-        SASSERT(w.is_clause());
-        try {
-            clause * c = w.get_clause();
-            propagate_clause(c, n);
-        }
-        catch (const typename config_mpq::exception &) {
-            // arithmetic module failed, ignore constraint
-            set_arith_failed();
-        }
-    }
+    SASSERT(m_wlist[x].empty());
+    propagate_clause_watches(x, n);
 }
 
 bool context_t::is_latest_bound(node * n, var x, uint64_t ts) {    
@@ -2147,25 +2617,19 @@ void context_t::propagate(node * n, bound * b) {
         return;
     TRACE("subpaving_propagate", tout << "propagate: "; display(tout, b); tout << ", timestamp: " << b->timestamp() << "\n";);
     ++m_curr_propagate;
+    propagate_clause_watches(x, n);
     typename watch_list::const_iterator it  = m_wlist[x].begin();
     typename watch_list::const_iterator end = m_wlist[x].end();
     for (; it != end; ++it) {
         if (inconsistent(n))
             return;
         watched const & w = *it;
+        SASSERT(w.is_definition());
         try {
-            if (w.is_clause()) {
-                clause * c = w.get_clause();
-                if (may_propagate(b, c, n)) {
-                    propagate_clause(c, n);
-                }
-            }
-            else {
-                var y = w.get_var();
-                definition * d = m_defs[y];
-                if (may_propagate(b, d, n)) {
-                    propagate_def(y, n);
-                }
+            var y = w.get_var();
+            definition * d = m_defs[y];
+            if (may_propagate(b, d, n)) {
+                propagate_def(y, n);
             }
         }
         catch (const typename config_mpq::exception &) {
@@ -2188,23 +2652,42 @@ void context_t::propagate(node * n) {
         m_temp_stringstream << "propagate node #" << n->id() << "\n";
         write_debug_ss_line_to_coordinator();
     }
+    if (n == m_root) {
+        init_clause_watches(n);
+    }
+    else {
+        switch_watches(n);
+        propagate_pending_watches(n);
+        propagate_new_lemmas(n);
+    }
     m_curr_propagate = 0;
-    time_t prop_start = std::time(nullptr);
-    // unsigned prop_start = static_cast<unsigned>(std::time(nullptr));
-    unsigned prop_time = 0;
+    std::chrono::steady_clock::time_point prop_start = std::chrono::steady_clock::now();
+    unsigned work_start   = prop_work();
+    unsigned bounds_start = m_num_mk_bounds;
+    unsigned budget_ms    = prop_budget_ms(n);
+    bool     extended     = false;
+    uint64_t prop_ms      = 0;
     while (!inconsistent(n) && m_qhead < m_queue.size()) {
-        // if (m_curr_propagate >= m_max_propagate)
-        //     break;
-
-        // prop_time = static_cast<unsigned>(std::time(nullptr)) - prop_start;
-        prop_time = static_cast<unsigned>(std::time(nullptr) - prop_start);
-        if (n->id() == 0) {
-            if (prop_time > m_root_max_prop_time)
-                break;
+        unsigned work = prop_work() - work_start;
+        if (m_max_prop_work != 0 && work > m_max_prop_work) {
+            m_num_prop_exhausted++;
+            break;
         }
-        else {
-            if (prop_time > m_max_prop_time)
+        prop_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now() - prop_start).count();
+        if (prop_ms > budget_ms) {
+            // A propagation that is still deriving bounds faster than the average
+            // one is allowed to run for twice its budget.
+            double yield = static_cast<double>(m_num_mk_bounds - bounds_start) / std::max(work, 1u);
+            if (!extended && m_num_prop_samples > 0 && yield > m_prop_yield) {
+                extended = true;
+                budget_ms *= 2;
+                m_num_prop_extended++;
+            }
+            else {
+                m_num_prop_exhausted++;
                 break;
+            }
         }
         checkpoint();
         bound * b = m_queue[m_qhead];
@@ -2215,20 +2698,52 @@ void context_t::propagate(node * n) {
         else
             propagate(n, b);
     }
+    if (!inconsistent(n)) {
+        // the budget ran out, the clauses watching the variables of the unprocessed bounds
+        // may watch false atoms at n
+        svector<var> & pending = n->pending_watch_vars();
+        for (unsigned i = m_qhead, sz = m_queue.size(); i < sz; i++)
+            pending.push_back(m_queue[i]->x());
+        m_num_pending_watch_vars += m_queue.size() - m_qhead;
+    }
+    {
+        unsigned work = prop_work() - work_start;
+        m_num_prop_work += work;
+        if (work > 0) {
+            double yield = static_cast<double>(m_num_mk_bounds - bounds_start) / work;
+            m_prop_yield = m_num_prop_samples == 0 ? yield : 0.9 * m_prop_yield + 0.1 * yield;
+            m_num_prop_samples++;
+        }
+    }
     {
         m_temp_stringstream
             << "node " << n->id()
             << ", propagated cnt: " << m_curr_propagate
-            // << "(" << m_max_propagate << ")"
-            << ", time: " << prop_time;
+            << ", work: " << prop_work() - work_start
+            << ", time: " << prop_ms << "ms";
         write_debug_ss_line_to_coordinator();
     }
     TRACE("linxi_subpaving", tout << "node #" << n->id() << " after propagation\n";
             display_bounds(tout, n););
+    m_prop_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - prop_start).count();
     m_queue.reset();
     m_qhead = 0;
 }
 
+unsigned context_t::prop_budget_ms(node * n) const {
+    if (n == m_root)
+        return m_root_max_prop_ms;
+    if (m_in_lookahead)
+        return std::max(m_lookahead_ms / (2 * m_lookahead), 1u);
+    // Spend less time on a node while workers are waiting for tasks.
+    if (m_max_running_tasks > 0 && m_alive_task_num < m_max_running_tasks) {
+        unsigned scaled = static_cast<unsigned>(
+            static_cast<uint64_t>(m_max_prop_ms) * (m_alive_task_num + 1) / m_max_running_tasks);
+        return std::max(scaled, m_max_prop_ms / 8);
+    }
+    return m_max_prop_ms;
+}
+
 void context_t::propagate_all_definitions(node * n) {
     unsigned num = num_vars();
     for (unsigned x = 0; x < num; x++) {
@@ -2281,11 +2796,39 @@ void context_t::assert_units(node * n) {
 }
 
 void context_t::write_line_to_coordinator(const std::string & line) {
-    std::cout << line << std::endl;
+    if (m_replaying)
+        return;
+    // lines are batched, see flush_lines_to_coordinator
+    std::cout << line << "\n";
 }
 
-void context_t::write_ss_line_to_coordinator() {
-    write_line_to_coordinator(m_temp_stringstream.str());
+void context_t::flush_lines_to_coordinator() {
+    // the journal covers every node the coordinator heard of
+    if (m_journal.is_open())
+        m_journal.flush();
+    std::cout.flush();
+    if (m_partitioner_debug)
+        m_debug_out.flush();
+}
+
+/**
+   \brief Block until the coordinator sends a message, or ms milliseconds passed.
+*/
+void context_t::wait_for_coordinator(unsigned ms) {
+    flush_lines_to_coordinator();
+    if (m_read_buffer_head < m_read_buffer_tail)
+        return;
+    struct pollfd pfd;
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    // after the coordinator closed the pipe, poll returns at once
+    if (poll(&pfd, 1, static_cast<int>(ms)) > 0 && !(pfd.revents & POLLIN))
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void context_t::write_ss_line_to_coordinator() {
+    write_line_to_coordinator(m_temp_stringstream.str());
     m_temp_stringstream.str("");
     m_temp_stringstream.clear();
     // {
@@ -2297,7 +2840,7 @@ void context_t::write_ss_line_to_coordinator() {
 void context_t::write_debug_line_to_coordinator(const std::string & line) {
     if (!m_partitioner_debug)
         return;
-    std::cout << control_message::P2C::debug_info << " " << line << std::endl;
+    m_debug_out << control_message::P2C::debug_info << " " << line << "\n";
 }
 
 // void context_t::write_debug_ss_line_to_coordinator() {
@@ -2325,12 +2868,12 @@ void context_t::write_debug_line_to_coordinator(const std::string & line) {
 
 
 void context_t::write_debug_ss_line_to_coordinator() {
-    if (!m_partitioner_debug)
-        return;
-    std::istringstream iss(m_temp_stringstream.str());
-    std::string line;
-    while (std::getline(iss, line)) {
-        write_debug_line_to_coordinator(line);
+    if (m_partitioner_debug) {
+        std::istringstream iss(m_temp_stringstream.str());
+        std::string line;
+        while (std::getline(iss, line)) {
+            write_debug_line_to_coordinator(line);
+        }
     }
     m_temp_stringstream.str("");
     m_temp_stringstream.clear();
@@ -2363,8 +2906,8 @@ bool context_t::read_line_from_coordinator() {
 
 void context_t::init_communication() {
     // write configuration
+    // lines are flushed when the coordinator has to see them, see flush_lines_to_coordinator
     std::ios::sync_with_stdio(false);
-    std::cout.setf(std::ios::unitbuf);
 
     // read configuration
     int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
@@ -2378,7 +2921,6 @@ void context_t::init_communication() {
 
 void context_t::init_partition() {
     m_init = true;
-    m_partitioner_debug = true;
     m_max_propagate = m_is_int.size();
 
     if (m_max_propagate > 1024)
@@ -2386,10 +2928,6 @@ void context_t::init_partition() {
     else if (m_max_propagate < 256u)
         m_max_propagate = 256u;
     
-    // second
-    m_root_max_prop_time = 10;
-    m_max_prop_time = 5;
-
     m_ptask->reset();
     m_var_occs.resize(num_vars());
     m_var_max_deg.resize(num_vars());
@@ -2399,17 +2937,41 @@ void context_t::init_partition() {
     m_split_prob_decay = 0.8;
     m_alive_task_num = 0;
     m_unsolved_task_num = 0;
-    m_var_key_num = 5;
+    m_var_key_num = node::num_keys;
 
     const params_ref &p = gparams::get_ref();
     m_output_dir = p.get_str("output_dir", "ERROR");
     SASSERT(m_output_dir != "ERROR");
+    m_partitioner_debug = p.get_uint("partition_debug", 0) != 0;
+    if (m_partitioner_debug) {
+        m_debug_out.open(m_output_dir + "/partitioner-debug.txt");
+        m_partitioner_debug = m_debug_out.is_open();
+    }
     {
         m_temp_stringstream << "output dir: " << m_output_dir;
         write_debug_ss_line_to_coordinator();
     }
     m_max_running_tasks = p.get_uint("partition_max_running_tasks", 32);
     m_max_alive_tasks = static_cast<unsigned>(m_max_running_tasks * 1.2) + 2;
+    m_root_max_prop_ms = p.get_uint("partition_root_prop_ms", 10000);
+    m_max_prop_ms = p.get_uint("partition_prop_ms", 5000);
+    m_max_prop_work = p.get_uint("partition_prop_work", 0);
+    m_prop_yield = 0.0;
+    m_num_prop_samples = 0;
+    m_lookahead = p.get_uint("partition_lookahead", 0);
+    m_lookahead_ms = p.get_uint("partition_lookahead_ms", 1000);
+    m_in_lookahead = false;
+    m_lookahead_bound_ready = false;
+    m_learn_lemmas = p.get_uint("partition_lemmas", 1) != 0;
+    m_gc = p.get_uint("partition_gc", 1) != 0;
+    m_export_lemmas = p.get_uint("partition_export_lemmas", 0) != 0;
+    if (p.get_uint("partition_cost_model", 0) == 1)
+        m_hardness_model = alloc(linear_hardness_model, 0.1);
+    if (p.get_uint("partition_lp_refute", 0) != 0)
+        m_lp_refuter = alloc(lp_refuter, nm());
+    m_lp_max_pivots = p.get_uint("partition_lp_pivots", 500);
+    m_sat_samples = p.get_uint("partition_sat_samples", 0);
+    m_fp_filter = p.get_uint("partition_fp_filter", 0) != 0;
     
     nm().set(m_tmp1, 1); // numerator
     nm().set(m_tmp2, 4); // denominator
@@ -2420,6 +2982,7 @@ void context_t::init_partition() {
     
     m_rand_seed = p.get_uint("partition_rand_seed", 0);
     m_rand.seed(m_rand_seed);
+    m_sample_rand.seed(m_rand_seed);
 
     init_communication();
 
@@ -2533,19 +3096,18 @@ bool context_t::test_dominated(vector<lit> & longer_cla, vector<lit> & shorter_c
     return true;
 }
 
+uint64_t context_t::clause_signature(vector<lit> const & cla) {
+    uint64_t sig = 0;
+    for (lit const & l : cla)
+        sig |= static_cast<uint64_t>(1) << (lit_key(l) & 63);
+    return sig;
+}
+
 void context_t::remove_dominated_clauses(vector<vector<lit>> & input, vector<vector<lit>> & output) {
-    const unsigned max_sz_thres = 10000;
+    SASSERT(output.empty());
     unsigned input_sz = input.size();
-    // for (unsigned i = 0; i < input_sz; ++i) {
-    //     output.push_back(std::move(input[i]));
-    // }
-    // return;
-    if (input_sz == 0 || input_sz > max_sz_thres) {
-        for (unsigned i = 0; i < input_sz; ++i) {
-            output.push_back(std::move(input[i]));
-        }
+    if (input_sz == 0)
         return;
-    }
     struct clause_info {
         unsigned id;
         unsigned sz;
@@ -2560,17 +3122,86 @@ void context_t::remove_dominated_clauses(vector<vector<lit>> & input, vector<vec
         clause_ids.push_back({i, input[i].size()});
     }
     std::sort(clause_ids.begin(), clause_ids.end());
-    for (unsigned i = 0; i < input_sz; ++i) {
-        vector<lit> & longer_cla = input[clause_ids[i].id];
+
+    // Clauses are processed by rank (position in clause_ids), and a clause can only be
+    // dominated by a kept clause of smaller rank. Every clause is indexed under its literal
+    // with the fewest occurrences: all literals of a dominating clause have a matching
+    // literal in the dominated one, so it is found by scanning the occurrence lists of
+    // the literals of the dominated clause.
+    unsigned num_keys = 6 * num_vars();
+    if (m_subsume_occs.size() < num_keys) {
+        m_subsume_occs.resize(num_keys);
+        m_subsume_cnts.resize(num_keys, 0);
+    }
+    svector<uint64_t> sigs;
+    unsigned_vector reg_pos;
+    for (unsigned r = 0; r < input_sz; ++r) {
+        vector<lit> & cla = input[clause_ids[r].id];
+        for (lit const & l : cla) {
+            unsigned k = lit_key(l);
+            if (m_subsume_cnts[k]++ == 0)
+                m_subsume_keys.push_back(k);
+        }
+        sigs.push_back(clause_signature(cla));
+    }
+    for (unsigned r = 0; r < input_sz; ++r) {
+        vector<lit> & cla = input[clause_ids[r].id];
+        unsigned best = 0;
+        for (unsigned j = 1, sz = cla.size(); j < sz; ++j) {
+            if (m_subsume_cnts[lit_key(cla[j])] < m_subsume_cnts[lit_key(cla[best])])
+                best = j;
+        }
+        reg_pos.push_back(best);
+        m_subsume_occs[lit_key(cla[best])].push_back(r);
+    }
+
+    ineq_lit_cmp ilc(nm());
+    auto reg_lit = [&](unsigned r) -> lit const & { return input[clause_ids[r].id][reg_pos[r]]; };
+    // Occurrence lists of inequality literals are ordered from the tightest bound to the
+    // loosest one, so the clauses whose indexed literal implies a given bound form a prefix.
+    for (unsigned k : m_subsume_keys) {
+        unsigned_vector & occs = m_subsume_occs[k];
+        if (occs.size() > 1 && reg_lit(occs[0]).is_ineq_lit())
+            std::sort(occs.begin(), occs.end(), [&](unsigned r1, unsigned r2) {
+                return ilc(reg_lit(r1), reg_lit(r2)) > 0;
+            });
+    }
+
+    bool_vector kept(input_sz, false);
+    unsigned_vector visited(input_sz, UINT_MAX);
+    for (unsigned r = 0; r < input_sz; ++r) {
+        vector<lit> & longer_cla = input[clause_ids[r].id];
+        uint64_t sig = sigs[r];
         bool is_dominated = false;
-        for (vector<lit> & shorter_cla : output) {
-            if (test_dominated(longer_cla, shorter_cla)) {
-                is_dominated = true;
-                break;
+        for (lit const & l : longer_cla) {
+            bool is_ineq = l.is_ineq_lit();
+            for (unsigned s : m_subsume_occs[lit_key(l)]) {
+                if (is_ineq && ilc(reg_lit(s), l) < 0)
+                    break;
+                if (s >= r || !kept[s] || visited[s] == r)
+                    continue;
+                visited[s] = r;
+                if ((sigs[s] & ~sig) != 0)
+                    continue;
+                if (test_dominated(longer_cla, input[clause_ids[s].id])) {
+                    is_dominated = true;
+                    break;
+                }
             }
+            if (is_dominated)
+                break;
         }
-        if (!is_dominated)
-            output.push_back(std::move(longer_cla));
+        kept[r] = !is_dominated;
+    }
+
+    for (unsigned k : m_subsume_keys) {
+        m_subsume_occs[k].reset();
+        m_subsume_cnts[k] = 0;
+    }
+    m_subsume_keys.reset();
+    for (unsigned r = 0; r < input_sz; ++r) {
+        if (kept[r])
+            output.push_back(std::move(input[clause_ids[r].id]));
     }
     unsigned removed_cnt = input.size() - output.size();
     if (removed_cnt > 0) {
@@ -2852,6 +3483,412 @@ bool context_t::simplify_ineqs_in_clause(vector<lit> & input, vector<lit> & outp
 }
 
 bool context_t::convert_node_to_task(node * n) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned nid = n->id();
+    if (m_task_residuals.size() <= nid) {
+        m_task_residuals.resize(nid + 1);
+        m_task_residual_valid.resize(nid + 1, false);
+    }
+    node * p = n->parent();
+    unsigned_vector const * parent_residual = nullptr;
+    if (p != nullptr && m_task_residual_valid[p->id()]) {
+        parent_residual = &m_task_residuals[p->id()];
+        mark_changed_vars(n, p);
+    }
+    bool is_unsat = convert_node_to_task_core(n, parent_residual);
+    unmark_changed_vars();
+    if (!is_unsat && refute_relaxation(n))
+        is_unsat = true;
+    m_task_residual_valid[nid] = !is_unsat;
+    if (is_unsat)
+        m_task_residuals[nid].finalize();
+    if (p != nullptr)
+        release_task_residual(p);
+    m_num_converted_nodes++;
+    m_convert_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return is_unsat;
+}
+
+bool context_t::refute_relaxation(node * n) {
+    // checks whose tableau gets more nonzero entries are given up
+    const unsigned max_lp_entries = 1 << 18;
+    if (m_lp_refuter == nullptr)
+        return false;
+    lp_refuter & lp = *m_lp_refuter;
+    lp.reset();
+    m_lp_vars.reset();
+    m_lp_vars.resize(num_vars(), UINT_MAX);
+    unsigned_vector xs;
+    bool has_polynomial = false;
+    for (var x = 0, sz = num_vars(); x < sz; ++x) {
+        if (!is_polynomial(x))
+            continue;
+        polynomial * p = get_polynomial(x);
+        xs.reset();
+        for (unsigned i = 0; i < p->size(); ++i)
+            xs.push_back(lp_var(n, p->x(i)));
+        lp.add_row(lp_var(n, x), xs.size(), xs.data(), p->as());
+        has_polynomial = true;
+    }
+    if (!has_polynomial)
+        return false; // the bounds of n are consistent, interval propagation already covers single monomials
+    scoped_mpq c(nm());
+    for (var x = 0, sz = num_vars(); x < sz; ++x) {
+        if (!is_monomial(x))
+            continue;
+        monomial * m = get_monomial(x);
+        var y, z;
+        if (m->size() == 1 && m->degree(0) == 2) {
+            y = z = m->x(0);
+        }
+        else if (m->size() == 2 && m->degree(0) == 1 && m->degree(1) == 1) {
+            y = m->x(0);
+            z = m->x(1);
+        }
+        else {
+            continue;
+        }
+        bound * ly = n->lower(y);
+        bound * uy = n->upper(y);
+        bound * lz = n->lower(z);
+        bound * uz = n->upper(z);
+        // (y - ly)(z - lz) >= 0
+        if (ly != nullptr && lz != nullptr) {
+            nm().mul(ly->value(), lz->value(), c);
+            nm().neg(c);
+            add_lp_envelope(n, x, lz->value(), y, ly->value(), z, c, true);
+        }
+        // (uy - y)(uz - z) >= 0
+        if (uy != nullptr && uz != nullptr) {
+            nm().mul(uy->value(), uz->value(), c);
+            nm().neg(c);
+            add_lp_envelope(n, x, uz->value(), y, uy->value(), z, c, true);
+        }
+        // (uy - y)(z - lz) >= 0
+        if (uy != nullptr && lz != nullptr) {
+            nm().mul(uy->value(), lz->value(), c);
+            nm().neg(c);
+            add_lp_envelope(n, x, lz->value(), y, uy->value(), z, c, false);
+        }
+        // (y - ly)(uz - z) >= 0, the same inequality as the previous one for a square
+        if (ly != nullptr && uz != nullptr && y != z) {
+            nm().mul(ly->value(), uz->value(), c);
+            nm().neg(c);
+            add_lp_envelope(n, x, uz->value(), y, ly->value(), z, c, false);
+        }
+    }
+    ++m_num_lp_checks;
+    if (lp.check(max_lp_entries, m_lp_max_pivots) != l_false)
+        return false;
+    ++m_num_lp_refuted;
+    {
+        m_temp_stringstream << "node-" << n->id() << " linear relaxation is infeasible, rows: "
+                            << lp.num_rows() << ", pivots: " << lp.num_pivots();
+        write_debug_ss_line_to_coordinator();
+    }
+    return true;
+}
+
+unsigned context_t::lp_var(node * n, var x) {
+    unsigned & v = m_lp_vars[x];
+    if (v != UINT_MAX)
+        return v;
+    v = m_lp_refuter->mk_var();
+    bound * l = n->lower(x);
+    bound * u = n->upper(x);
+    // open bounds are relaxed to non-strict ones
+    if (l != nullptr)
+        m_lp_refuter->set_lower(v, l->value());
+    if (u != nullptr)
+        m_lp_refuter->set_upper(v, u->value());
+    return v;
+}
+
+void context_t::add_lp_envelope(node * n, var x, numeral const & a, var y, numeral const & b, var z,
+                                numeral const & c, bool lower) {
+    unsigned s = m_lp_refuter->mk_var();
+    if (lower)
+        m_lp_refuter->set_lower(s, c);
+    else
+        m_lp_refuter->set_upper(s, c);
+    unsigned xs[3] = { lp_var(n, x), lp_var(n, y), lp_var(n, z) };
+    scoped_mpq_vector as(nm());
+    as.resize(3);
+    nm().set(as[0], 1);
+    nm().set(as[1], a);
+    nm().neg(as[1]);
+    nm().set(as[2], b);
+    nm().neg(as[2]);
+    m_lp_refuter->add_row(s, 3, xs, as.data());
+}
+
+bool context_t::find_model(node * n, unsigned budget) {
+    m_model.resize(num_vars());
+    for (var x = 0, sz = num_vars(); x < sz; ++x) {
+        if (!is_definition(x) && !sample_value(n, x, true))
+            return false;
+    }
+    var culprit;
+    double dist;
+    unsigned best = num_violations(n, culprit, dist);
+    unsigned used = 1;
+    scoped_mpq old(nm());
+    while (best > 0 && used < budget) {
+        var y = culprit;
+        nm().set(old, m_model[y]);
+        if (!sample_value(n, y, false))
+            return false;
+        var c;
+        double d;
+        unsigned k = num_violations(n, c, d);
+        ++used;
+        if (k < best || (k == best && d <= dist)) {
+            best = k;
+            dist = d;
+            culprit = c;
+            continue;
+        }
+        // the move is undone, the definitions are evaluated again and another constraint may be picked
+        nm().set(m_model[y], old);
+        best = num_violations(n, culprit, dist);
+        ++used;
+    }
+    m_num_sat_samples += used;
+    return best == 0;
+}
+
+double context_t::box_distance(node * n, var x, numeral const & v) const {
+    bound * l = n->lower(x);
+    bound * u = n->upper(x);
+    if (l != nullptr && (nm().lt(v, l->value()) || (l->is_open() && nm().eq(v, l->value()))))
+        return nm().get_double(l->value()) - nm().get_double(v) + 1.0;
+    if (u != nullptr && (nm().gt(v, u->value()) || (u->is_open() && nm().eq(v, u->value()))))
+        return nm().get_double(v) - nm().get_double(u->value()) + 1.0;
+    return is_int(x) && !nm().is_int(v) ? 1.0 : 0.0;
+}
+
+bool context_t::sample_value(node * n, var x, bool simple) {
+    numeral & v = m_model[x];
+    if (m_is_bool[x]) {
+        bvalue_kind bk = n->bvalue(x);
+        bool b = bk == b_true || (bk == b_undef && !simple && m_sample_rand() % 2 == 1);
+        nm().set(v, b ? 1 : 0);
+        return true;
+    }
+    bound * l = n->lower(x);
+    bound * u = n->upper(x);
+    scoped_mpq c(nm()), w(nm());
+    // candidates: 0 or a random value, the ends of the box, its middle (rounded down and up)
+    for (unsigned i = 0; i < 5; ++i) {
+        switch (i) {
+        case 0:
+            if (simple) {
+                nm().reset(c);
+            }
+            else if (l != nullptr && u != nullptr) {
+                nm().sub(u->value(), l->value(), w);
+                nm().mul(w, mpq(m_sample_rand() % 17), w);
+                nm().div(w, mpq(16), w);
+                nm().add(l->value(), w, c);
+            }
+            else if (l != nullptr) {
+                nm().ceil(l->value(), c);
+                nm().add(c, mpq(m_sample_rand() % 17), c);
+            }
+            else if (u != nullptr) {
+                nm().floor(u->value(), c);
+                nm().sub(c, mpq(m_sample_rand() % 17), c);
+            }
+            else {
+                nm().set(c, static_cast<int>(m_sample_rand() % 33) - 16);
+            }
+            break;
+        case 1:
+            if (l == nullptr)
+                continue;
+            nm().ceil(l->value(), c);
+            break;
+        case 2:
+            if (u == nullptr)
+                continue;
+            nm().floor(u->value(), c);
+            break;
+        default:
+            if (l != nullptr && u != nullptr) {
+                nm().add(l->value(), u->value(), c);
+                nm().div(c, mpq(2), c);
+            }
+            else if (l != nullptr) {
+                nm().add(l->value(), mpq(1), c);
+            }
+            else if (u != nullptr) {
+                nm().sub(u->value(), mpq(1), c);
+            }
+            else {
+                nm().reset(c);
+            }
+            if (i == 3)
+                nm().floor(c, c);
+            else if (is_int(x))
+                nm().ceil(c, c);
+            break;
+        }
+        if (is_int(x) && !nm().is_int(c))
+            nm().floor(c, c);
+        if (box_distance(n, x, c) == 0.0) {
+            nm().set(v, c);
+            return true;
+        }
+    }
+    return false;
+}
+
+double context_t::atom_distance(atom * a) const {
+    numeral const & v = m_model[a->x()];
+    if (a->is_bool_atom())
+        return nm().is_zero(v) == a->is_lower() ? 0.0 : 1.0;
+    if (a->is_eq_atom()) {
+        if (nm().eq(v, a->value()) != a->is_lower())
+            return 0.0;
+        return a->is_lower() ? 1.0 : std::fabs(nm().get_double(v) - nm().get_double(a->value()));
+    }
+    int c = nm().lt(v, a->value()) ? -1 : (nm().gt(v, a->value()) ? 1 : 0);
+    if (a->is_lower() ? (c > 0 || (c == 0 && !a->is_open())) : (c < 0 || (c == 0 && !a->is_open())))
+        return 0.0;
+    return std::fabs(nm().get_double(v) - nm().get_double(a->value())) + 1.0;
+}
+
+unsigned context_t::num_violations(node * n, var & culprit, double & dist) {
+    scoped_mpq tmp(nm());
+    unsigned num = 0;
+    culprit = null_var;
+    dist = 0.0;
+    // reservoir sampling of the violated constraint
+    auto violated = [&](var x, double d) {
+        ++num;
+        dist += d;
+        if (m_sample_rand() % num == 0)
+            culprit = pick_input_var(x);
+    };
+    // a definition only refers to variables created before it
+    for (var x = 0, sz = num_vars(); x < sz; ++x) {
+        if (!is_definition(x))
+            continue;
+        numeral & v = m_model[x];
+        if (is_polynomial(x)) {
+            polynomial * p = get_polynomial(x);
+            nm().reset(v);
+            for (unsigned i = 0; i < p->size(); ++i) {
+                nm().mul(p->a(i), m_model[p->x(i)], tmp);
+                nm().add(v, tmp, v);
+            }
+        }
+        else {
+            monomial * m = get_monomial(x);
+            nm().set(v, 1);
+            for (unsigned i = 0; i < m->size(); ++i) {
+                nm().power(m_model[m->x(i)], m->degree(i), tmp);
+                nm().mul(v, tmp, v);
+            }
+        }
+        double d = box_distance(n, x, v);
+        if (d > 0.0)
+            violated(x, d);
+    }
+    for (atom * a : m_unit_clauses) {
+        double d = atom_distance(a);
+        if (d > 0.0)
+            violated(a->x(), d);
+    }
+    for (clause * c : m_clauses) {
+        double d = 0.0;
+        for (unsigned i = 0, sz = c->size(); i < sz; ++i) {
+            double di = atom_distance((*c)[i]);
+            if (i == 0 || di < d)
+                d = di;
+            if (d == 0.0)
+                break;
+        }
+        if (d > 0.0)
+            violated((*c)[m_sample_rand() % c->size()]->x(), d);
+    }
+    return num;
+}
+
+var context_t::pick_input_var(var x) {
+    while (is_definition(x)) {
+        if (is_polynomial(x)) {
+            polynomial * p = get_polynomial(x);
+            x = p->x(m_sample_rand() % p->size());
+        }
+        else {
+            monomial * m = get_monomial(x);
+            x = m->x(m_sample_rand() % m->size());
+        }
+    }
+    return x;
+}
+
+void context_t::mark_changed_vars(node * n, node * p) {
+    m_changed_var.resize(num_vars(), false);
+    bound * b_old = p->trail_stack();
+    for (bound * b = n->trail_stack(); b != b_old; b = b->prev()) {
+        var x = b->x();
+        if (!m_changed_var[x]) {
+            m_changed_var[x] = true;
+            m_changed_vars.push_back(x);
+        }
+    }
+}
+
+void context_t::unmark_changed_vars() {
+    for (var x : m_changed_vars)
+        m_changed_var[x] = false;
+    m_changed_vars.reset();
+}
+
+void context_t::release_task_residual(node * n) {
+    if (n->id() >= m_task_residuals.size() || !m_task_residual_valid[n->id()])
+        return;
+    for (node * c = n->first_child(); c != nullptr; c = c->next_sibling()) {
+        if (m_nodes_state[c->id()] == node_state::UNCONVERTED && 
+            (c->id() >= m_task_residuals.size() || !m_task_residual_valid[c->id()]))
+            return; // c was not converted yet
+    }
+    m_task_residual_valid[n->id()] = false;
+    m_task_residuals[n->id()].finalize();
+}
+
+void context_t::add_task_clause(task_info & task, vector<lit> & temp_units, vector<vector<lit>> & temp_clauses) {
+    if (m_temp_atom_buffer.size() == 1) {
+        temp_units.push_back(std::move(convert_atom_to_lit(m_temp_atom_buffer[0])));
+        return;
+    }
+    ++task.m_undef_clause_num;
+    task.m_undef_lit_num += m_temp_atom_buffer.size();
+    vector<lit> lit_cla, simp_lit_cla;
+    for (unsigned j = 0, jsz = m_temp_atom_buffer.size(); j < jsz; ++j) {
+        atom * a = m_temp_atom_buffer[j];
+        lit_cla.push_back(std::move(convert_atom_to_lit(a)));
+    }
+    // temp_clauses.push_back(std::move(lit_cla));
+    if (simplify_ineqs_in_clause(lit_cla, simp_lit_cla, false)) {
+        ++m_skip_clause_cnt;
+    }
+    else {
+        unsigned simp_sz = simp_lit_cla.size();
+        assert(simp_sz > 0);
+        if (simp_sz == 1) {
+            temp_units.push_back(std::move(simp_lit_cla[0]));
+        }
+        else {
+            temp_clauses.push_back(std::move(simp_lit_cla));
+        }
+        task.m_undef_lit_num += simp_lit_cla.size();
+    }
+}
+
+bool context_t::convert_node_to_task_core(node * n, unsigned_vector const * parent_residual) {
     // bool encode_all_variables = true;
     bool encode_all_variables = false;
     task_info & task = *m_ptask;
@@ -2874,13 +3911,35 @@ bool context_t::convert_node_to_task(node * n) {
     // }
     // return false;
 
-    for (unsigned i = 0, isz = m_clauses.size(); i < isz; ++i) {
-        clause * cla = m_clauses[i];
+    unsigned_vector & residual = m_task_residuals[n->id()];
+    residual.reset();
+    unsigned i = 0;
+    unsigned isz = parent_residual != nullptr ? parent_residual->size() : m_clauses.size();
+    while (i < isz) {
+        // atoms that are not in the parent residual are false at the parent, and so they are false at n.
+        unsigned cidx, k;
+        unsigned const * pos;
+        if (parent_residual != nullptr) {
+            cidx = (*parent_residual)[i];
+            k    = (*parent_residual)[i + 1];
+            pos  = parent_residual->data() + i + 2;
+            i   += 2 + k;
+        }
+        else {
+            cidx = i;
+            k    = m_clauses[i]->m_size;
+            pos  = nullptr;
+            i++;
+        }
+        clause * cla = m_clauses[cidx];
         m_temp_atom_buffer.reset();
+        m_temp_pos_buffer.reset();
         bool skippable = false;
-        for (unsigned j = 0, jsz = cla->m_size; j < jsz; ++j) {
+        for (unsigned t = 0; t < k; ++t) {
+            unsigned j = pos != nullptr ? pos[t] : t;
             atom * a = (*cla)[j];
-            lbool res = value(a, n);
+            // atoms on variables with unchanged bounds are still undefined.
+            lbool res = (parent_residual == nullptr || is_changed_var(a->x())) ? value(a, n) : l_undef;
             TRACE("linxi_subpaving",
                 tout << "atom: ";
                 display(tout, a);
@@ -2899,6 +3958,7 @@ bool context_t::convert_node_to_task(node * n) {
             }
             else {
                 m_temp_atom_buffer.push_back(a);
+                m_temp_pos_buffer.push_back(j);
             }
         }
         if (skippable)
@@ -2910,31 +3970,30 @@ bool context_t::convert_node_to_task(node * n) {
             }
             return true;
         }
-        if (m_temp_atom_buffer.size() == 1) {
-            temp_units.push_back(std::move(convert_atom_to_lit(m_temp_atom_buffer[0])));
-            continue;
-        }
-        ++task.m_undef_clause_num;
-        task.m_undef_lit_num += m_temp_atom_buffer.size();
-        vector<lit> lit_cla, simp_lit_cla;
-        for (unsigned j = 0, jsz = m_temp_atom_buffer.size(); j < jsz; ++j) {
-            atom * a = m_temp_atom_buffer[j];
-            lit_cla.push_back(std::move(convert_atom_to_lit(a)));
-        }
-        // temp_clauses.push_back(std::move(lit_cla));
-        if (simplify_ineqs_in_clause(lit_cla, simp_lit_cla, false)) {
-            ++m_skip_clause_cnt;
-        }
-        else {
-            unsigned simp_sz = simp_lit_cla.size();
-            assert(simp_sz > 0);
-            if (simp_sz == 1) {
-                temp_units.push_back(std::move(simp_lit_cla[0]));
-            }
-            else {
-                temp_clauses.push_back(std::move(simp_lit_cla));
+        residual.push_back(cidx);
+        residual.push_back(m_temp_pos_buffer.size());
+        residual.append(m_temp_pos_buffer.size(), m_temp_pos_buffer.data());
+        add_task_clause(task, temp_units, temp_clauses);
+    }
+
+    if (m_export_lemmas) {
+        for (clause * cla : m_lemmas) {
+            m_temp_atom_buffer.reset();
+            bool skippable = false;
+            for (unsigned j = 0, jsz = cla->size(); j < jsz; ++j) {
+                atom * a = (*cla)[j];
+                lbool res = value(a, n);
+                if (res == l_true) {
+                    skippable = true;
+                    break;
+                }
+                if (res == l_undef)
+                    m_temp_atom_buffer.push_back(a);
             }
-            task.m_undef_lit_num += simp_lit_cla.size();
+            // lemmas false at n are detected by propagation
+            if (skippable || m_temp_atom_buffer.empty())
+                continue;
+            add_task_clause(task, temp_units, temp_clauses);
         }
     }
     
@@ -2950,8 +4009,12 @@ bool context_t::convert_node_to_task(node * n) {
             // ++task.m_undef_lit_num;
         }
     
-        for (unsigned i = 0, sz = n->up_atoms().size(); i < sz; ++i) {
-            atom * at = n->up_atoms()[i];
+        // the up atom list is newest first, export it from the root down
+        ptr_buffer<atom> up_atoms;
+        for (up_atom_cell * c = n->up_atoms(); c != nullptr; c = c->m_next)
+            up_atoms.push_back(c->m_atom);
+        for (unsigned i = up_atoms.size(); i-- > 0; ) {
+            atom * at = up_atoms[i];
             if (m_defs[at->m_x] == nullptr)
                 continue;
             temp_units.push_back(std::move(convert_atom_to_lit(at)));
@@ -3299,90 +4362,98 @@ void context_t::select_best_var(node * n) {
     // for (unsigned i = 0; i < m_var_key_num; ++i) {
     //     m_curr_var_info.m_key_rank[i] = n->key_rank()[i];
     // }
-    std::uniform_real_distribution<> dis(0.0, 1.0);
+    m_lookahead_vars.reset();
     for (unsigned i = 0, x; i < sz; ++i) {
         x = m_var_split_candidates[i];
-        bound * l = n->lower(x);
-        bound * u = n->upper(x);
-        if (l != nullptr && u != nullptr 
-         && nm().eq(l->value(), u->value())) {
-            continue;
-        }
-        if (m_var_occs[x] == 0)
+        if (!calc_var_info(n, x, m_curr_var_info))
             continue;
-        unsigned split_cnt = m_var_unsolved_split_cnt[x];
-        double avg_split_cnt = 
-            static_cast<double>(split_cnt) / static_cast<double>(m_unsolved_task_num);
-        // double choose_prob = pow(m_split_prob_decay, avg_split_cnt);
-        // if (split_cnt > 0) {
-        //     m_temp_stringstream << "var " << x << ", avg_split_cnt: " << avg_split_cnt
-        //         << ", choose_prob: " << choose_prob << ", unsolved split cnt: " << split_cnt;
-        //     write_debug_ss_line_to_coordinator();
-        // }
-        // if (m_best_var_info.m_id != null_var && dis(m_rand) > choose_prob)
-        //     continue;
-        // if (split_cnt > 0) {
-        //     m_temp_stringstream << "var " << x << " is chosen";
-        //     write_debug_ss_line_to_coordinator();
-        // }
-        m_curr_var_info.m_id = x;
-        m_curr_var_info.m_split_cnt = m_var_unsolved_split_cnt[x];
-        m_curr_var_info.m_avg_split_cnt = avg_split_cnt;
-        m_curr_var_info.m_cz = ((l == nullptr || nm().is_neg(l->value())) 
-                             && (u == nullptr || nm().is_pos(u->value())));
-        m_curr_var_info.m_deg = m_var_max_deg[x];
-        m_curr_var_info.m_occ = m_var_occs[x];
-        m_curr_var_info.m_is_too_short = false;
-        numeral & width = m_curr_var_info.m_width;
-        if (l == nullptr && u == nullptr) {
-            nm().set(width, m_unbounded_penalty_sq);
-            // unbouned: width = penalty ^ 2
-            m_curr_var_info.m_width_score = 1.0;
-        }
-        else if (l == nullptr) {
-            if (nm().is_neg(u->value())) {
-                nm().set(width, u->value());
-                nm().neg(width);
-                if (nm().lt(width, 1))
-                    nm().set(width, 1);
-                nm().div(m_unbounded_penalty, width, width);
-                // u < 0: penalty / max(1, -u)
-            }
-            else {
-                nm().add(u->value(), m_unbounded_penalty, width);
-                // u >= 0: penalty + u
-            }
-            m_curr_var_info.m_width_score = 0.95;
+        if (m_best_var_info.m_id == null_var || m_curr_var_info < m_best_var_info) {
+            m_best_var_info.copy(m_curr_var_info);
         }
-        else if (u == nullptr) {
-            if (nm().is_pos(l->value())) {
-                nm().set(width, l->value());
-                if (nm().lt(width, 1))
-                    nm().set(width, 1);
-                nm().div(m_unbounded_penalty, width, width);
-                // l > 0: penalty / max(1, l)
-            }
-            else {
-                nm().set(width, l->value());
-                nm().neg(width);
-                nm().add(width, m_unbounded_penalty, width);
-                // l <= 0: penalty + -l
-            }
-            m_curr_var_info.m_width_score = 0.95;
+        if (m_lookahead > 0 && !m_curr_var_info.m_is_too_short)
+            add_lookahead_var(x, m_curr_var_info.m_score);
+    }
+}
+
+bool context_t::calc_var_info(node * n, var x, var_info & info) {
+    bound * l = n->lower(x);
+    bound * u = n->upper(x);
+    if (l != nullptr && u != nullptr 
+     && nm().eq(l->value(), u->value())) {
+        return false;
+    }
+    if (m_var_occs[x] == 0)
+        return false;
+    unsigned split_cnt = m_var_unsolved_split_cnt[x];
+    double avg_split_cnt = 
+        static_cast<double>(split_cnt) / static_cast<double>(m_unsolved_task_num);
+    // double choose_prob = pow(m_split_prob_decay, avg_split_cnt);
+    // if (split_cnt > 0) {
+    //     m_temp_stringstream << "var " << x << ", avg_split_cnt: " << avg_split_cnt
+    //         << ", choose_prob: " << choose_prob << ", unsolved split cnt: " << split_cnt;
+    //     write_debug_ss_line_to_coordinator();
+    // }
+    // if (m_best_var_info.m_id != null_var && dis(m_rand) > choose_prob)
+    //     continue;
+    // if (split_cnt > 0) {
+    //     m_temp_stringstream << "var " << x << " is chosen";
+    //     write_debug_ss_line_to_coordinator();
+    // }
+    info.m_id = x;
+    info.m_split_cnt = m_var_unsolved_split_cnt[x];
+    info.m_avg_split_cnt = avg_split_cnt;
+    info.m_cz = ((l == nullptr || nm().is_neg(l->value())) 
+              && (u == nullptr || nm().is_pos(u->value())));
+    info.m_deg = m_var_max_deg[x];
+    info.m_occ = m_var_occs[x];
+    info.m_is_too_short = false;
+    numeral & width = info.m_width;
+    if (l == nullptr && u == nullptr) {
+        nm().set(width, m_unbounded_penalty_sq);
+        // unbouned: width = penalty ^ 2
+        info.m_width_score = 1.0;
+    }
+    else if (l == nullptr) {
+        if (nm().is_neg(u->value())) {
+            nm().set(width, u->value());
+            nm().neg(width);
+            if (nm().lt(width, 1))
+                nm().set(width, 1);
+            nm().div(m_unbounded_penalty, width, width);
+            // u < 0: penalty / max(1, -u)
         }
         else {
-            nm().sub(u->value(), l->value(), width);
-            m_curr_var_info.m_width_score = 0.9;
+            nm().add(u->value(), m_unbounded_penalty, width);
+            // u >= 0: penalty + u
         }
-        if (nm().le(width, m_small_value_thres)) {
-            // m_curr_var_info.m_width_score = 0.9;
-            m_curr_var_info.m_is_too_short = true;
+        info.m_width_score = 0.95;
+    }
+    else if (u == nullptr) {
+        if (nm().is_pos(l->value())) {
+            nm().set(width, l->value());
+            if (nm().lt(width, 1))
+                nm().set(width, 1);
+            nm().div(m_unbounded_penalty, width, width);
+            // l > 0: penalty / max(1, l)
         }
-        m_curr_var_info.calc_score();
-        if (m_best_var_info.m_id == null_var || m_curr_var_info < m_best_var_info) {
-            m_best_var_info.copy(m_curr_var_info);
+        else {
+            nm().set(width, l->value());
+            nm().neg(width);
+            nm().add(width, m_unbounded_penalty, width);
+            // l <= 0: penalty + -l
         }
+        info.m_width_score = 0.95;
+    }
+    else {
+        nm().sub(u->value(), l->value(), width);
+        info.m_width_score = 0.9;
     }
+    if (nm().le(width, m_small_value_thres)) {
+        // info.m_width_score = 0.9;
+        info.m_is_too_short = true;
+    }
+    info.calc_score();
+    return true;
 }
 
 // return true for already unsat
@@ -3406,10 +4477,10 @@ bool context_t::update_node_state_unsat(unsigned id) {
     // }
     node * n = m_nodes[id];
     --m_unsolved_task_num;
-    for (unsigned i = 0, sz = n->depth(); i < sz; ++i) {
-        --m_var_unsolved_split_cnt[n->split_vars()[i]];
+    for (node * a = n; a->depth() > 0; a = a->parent()) {
+        --m_var_unsolved_split_cnt[a->split_var()];
     }
-    sta = node_state::UNSAT;
+    set_node_state(id, node_state::UNSAT);
     return false;
 }
 
@@ -3461,25 +4532,110 @@ void context_t::node_solved_unsat(node * n) {\
     }
 }
 
+void context_t::set_node_state(unsigned id, node_state sta) {
+    m_nodes_state[id] = sta;
+    if (sta == node_state::UNSAT || sta == node_state::TERMINATED)
+        m_gc_candidates.push_back(id);
+}
+
+void context_t::release_node_data(node * n) {
+    bm().del(n->lowers());
+    bm().del(n->uppers());
+    bvm().del(n->bvalues());
+    // up atom cells are shared with the children, they are released by del_node
+}
+
+void context_t::del_subtree(node * n) {
+    node * p = n->parent();
+    ptr_buffer<node> todo;
+    todo.push_back(n);
+    while (!todo.empty()) {
+        node * curr = todo.back();
+        node * c = curr->first_child();
+        if (c == nullptr) {
+            unsigned id = curr->id();
+            del_node(curr);
+            m_nodes[id] = nullptr;
+            m_num_collected_nodes++;
+            todo.pop_back();
+        }
+        else {
+            while (c != nullptr) {
+                todo.push_back(c);
+                c = c->next_sibling();
+            }
+        }
+    }
+    if (p != nullptr)
+        release_task_residual(p);
+}
+
+void context_t::collect_garbage() {
+    if (!m_gc) {
+        m_gc_candidates.reset();
+        return;
+    }
+    unsigned old_collected = m_num_collected_nodes;
+    for (unsigned id : m_gc_candidates) {
+        node * n = m_nodes[id];
+        if (n == nullptr || n == m_root)
+            continue;
+        if (m_nodes_state[id] == node_state::TERMINATED) {
+            // the children of a terminated node still cover its region
+            release_node_data(n);
+            continue;
+        }
+        SASSERT(m_nodes_state[id] == node_state::UNSAT);
+        node * p = n->parent();
+        // the whole subtree of an UNSAT node is UNSAT, collect it from its topmost UNSAT ancestor
+        if (p != nullptr && m_nodes_state[p->id()] == node_state::UNSAT)
+            continue;
+        del_subtree(n);
+    }
+    m_gc_candidates.reset();
+    if (m_num_collected_nodes > old_collected) {
+        m_temp_stringstream << "collected nodes: " << m_num_collected_nodes - old_collected
+            << ", live nodes: " << m_num_nodes;
+        write_debug_ss_line_to_coordinator();
+    }
+}
+
 void context_t::parse_line(const std::string & line) {
     std::stringstream ss(line);
     int op_id;
     ss >> op_id;
     control_message::C2P op = control_message::C2P(op_id);
+    // the coordinator may append the time (in seconds) spent solving the task of the node
+    double time;
+    unsigned id = UINT32_MAX;
+    ss >> id;
+    if (op == control_message::C2P::export_subtree) {
+        std::string path;
+        std::getline(ss >> std::ws, path);
+        // the subtree was exported by the previous process
+        if (!m_replaying)
+            export_subtree(id, path);
+        return;
+    }
+    // a restarted partitioner may not know the last nodes of the previous one
+    if (id >= m_nodes.size())
+        return;
     if (op == control_message::C2P::unsat_node) {
-        unsigned id;
-        ss >> id;
-        node_solved_unsat(m_nodes[id]);
+        if (ss >> time)
+            observe_solving_time(id, time, true);
+        // collected nodes are already unsat
+        if (m_nodes[id] != nullptr)
+            node_solved_unsat(m_nodes[id]);
     }
     else if (op == control_message::C2P::terminate_node) {
-        unsigned id;
-        ss >> id;
+        if (ss >> time)
+            observe_solving_time(id, time, false);
         if (m_nodes_state[id] == node_state::WAITING) {
             // {
             //     m_temp_stringstream << "node-" << id << " is terminated";
             //     write_debug_ss_line_to_coordinator();
             // }
-            m_nodes_state[id] = node_state::TERMINATED;
+            set_node_state(id, node_state::TERMINATED);
             --m_alive_task_num;
         }
     }
@@ -3491,6 +4647,9 @@ void context_t::parse_line(const std::string & line) {
 void context_t::communicate_with_coordinator() {
     while (read_line_from_coordinator()) {
         write_debug_line_to_coordinator("read line from coordinator: " + m_current_line);
+        journal_record r(journal_record::MESSAGE);
+        r.m_text = m_current_line;
+        journal(r);
         parse_line(m_current_line);
         m_current_line = "";
         {
@@ -3531,114 +4690,27 @@ typename context_t::node * context_t::select_next_node() {
     return m_nodes[nid];
 }
 
-void context_t::split_node(node * n) {
-    select_best_var(n);
-    unsigned id = m_best_var_info.m_id;
-    if (id == null_var) {
-        write_debug_line_to_coordinator("no split var is selected");
-        return;
-    }
-    write_debug_line_to_coordinator("best var: " + m_best_var_info.to_string());
-    TRACE("linxi_subpaving", 
-        var x = id;
-        tout << "best var interval: " << x << "\n";
-        bound * l = n->lower(x);
-        bound * u = n->upper(x);
-        if (l != nullptr) {
-            display(tout, l);
-            tout << " ";
-        }
-        if (u != nullptr) {
-            display(tout, u);
-        }
-        if (l != nullptr || u != nullptr)
-            tout << "\n";
-    );
-    node * left   = this->mk_node(n);
-    node * right  = this->mk_node(n);
-    
-    // ++m_var_split_cnt[id];
-    // m_var_split_prob[id] *= m_split_prob_decay;
-    left->split_vars().push_back(id);
-    right->split_vars().push_back(id);
-
-    bool blower, bopen;
-    // numeral & mid = m_tmp1;
-    scoped_mpq mid(nm());
-
-    vector<lit> x_lits;
-    // vector<lit> x_lb_lits, x_ub_lits;
-    for (const vector<lit> & cla : m_ptask->m_clauses) {
-        for (const lit & l : cla) {
-            // if (l.m_bool)
-            //     continue;
-            if (l.m_x != id)
-                continue;
-            if (l.is_eq_lit())
-                continue;
-            x_lits.push_back(l);
-            // if (l.m_lower)
-            //     x_lb_lits.push_back(l);
-            // else
-            //     x_ub_lits.push_back(l);
-        }
+void context_t::collect_split_lits(var x, vector<lit> & x_lits) {
+    // vector<lit> x_lb_lits, x_ub_lits;
+    for (const vector<lit> & cla : m_ptask->m_clauses) {
+        for (const lit & l : cla) {
+            // if (l.m_bool)
+            //     continue;
+            if (l.m_x != x)
+                continue;
+            if (l.is_eq_lit())
+                continue;
+            x_lits.push_back(l);
+            // if (l.m_lower)
+            //     x_lb_lits.push_back(l);
+            // else
+            //     x_ub_lits.push_back(l);
+        }
     }
+}
 
+void context_t::select_split_bound(node * n, var id, bool cz, vector<lit> & x_lits, numeral & mid, bool & blower, bool & bopen) {
     unsigned x_lits_sz = x_lits.size();
-    {
-        m_temp_stringstream << "x_lits_sz: " << x_lits_sz;
-        write_debug_ss_line_to_coordinator();
-        
-        m_temp_stringstream << "split var-"<< id;
-        write_debug_ss_line_to_coordinator();
-
-        bound * lb = n->lower(id);
-        m_temp_stringstream << "x_lower: ";
-        if (lb == nullptr) {
-            m_temp_stringstream << "null";
-        }
-        else {
-            display(m_temp_stringstream, lb);
-        }
-        write_debug_ss_line_to_coordinator();
-
-        bound * ub = n->upper(id);
-        m_temp_stringstream << "x_upper: ";
-        if (ub == nullptr) {
-            m_temp_stringstream << "null";
-        }
-        else {
-            display(m_temp_stringstream, ub);
-        }
-        write_debug_ss_line_to_coordinator();
-    }
-
-    // {
-    //     var vid = 1856;
-    //     m_temp_stringstream << "var-"<< vid;
-    //     write_debug_ss_line_to_coordinator();
-
-    //     bound * lb = n->lower(vid);
-    //     m_temp_stringstream << "x_lower: ";
-    //     if (lb == nullptr) {
-    //         m_temp_stringstream << "null";
-    //     }
-    //     else {
-    //         display(m_temp_stringstream, lb);
-    //     }
-    //     write_debug_ss_line_to_coordinator();
-
-    //     bound * ub = n->upper(vid);
-    //     m_temp_stringstream << "x_upper: ";
-    //     if (ub == nullptr) {
-    //         m_temp_stringstream << "null";
-    //     }
-    //     else {
-    //         display(m_temp_stringstream, ub);
-    //     }
-    //     write_debug_ss_line_to_coordinator();
-    // }
-
     if (x_lits_sz > 0) {
     // if (false) {
         // {
@@ -3712,7 +4784,7 @@ void context_t::split_node(node * n) {
         blower = false;
         bopen = false;
         // x <= mid, x > mid
-        if (m_best_var_info.m_cz) {
+        if (cz) {
             nm().set(mid, 0);
             // mid == 0
         }
@@ -3748,6 +4820,534 @@ void context_t::split_node(node * n) {
             // mid == (lower + upper)/2
         }
     }
+}
+
+void context_t::add_lookahead_var(var x, double score) {
+    unsigned i = m_lookahead_vars.size();
+    m_lookahead_vars.push_back(std::make_pair(score, x));
+    // keep the candidates ordered by decreasing score
+    for (; i > 0; --i) {
+        std::pair<double, var> & prev = m_lookahead_vars[i - 1];
+        if (prev.first > score || (prev.first == score && prev.second < x))
+            break;
+        std::swap(prev, m_lookahead_vars[i]);
+    }
+    if (m_lookahead_vars.size() > m_lookahead)
+        m_lookahead_vars.pop_back();
+}
+
+unsigned context_t::count_reduced_lits(node * c) {
+    node * p = c->parent();
+    if (p->id() >= m_task_residuals.size() || !m_task_residual_valid[p->id()])
+        return 0;
+    mark_changed_vars(c, p);
+    unsigned_vector const & residual = m_task_residuals[p->id()];
+    unsigned reduced = 0;
+    unsigned i = 0, sz = residual.size();
+    while (i < sz) {
+        clause * cla = m_clauses[residual[i]];
+        unsigned k = residual[i + 1];
+        unsigned const * pos = residual.data() + i + 2;
+        i += 2 + k;
+        unsigned false_cnt = 0;
+        bool satisfied = false;
+        for (unsigned t = 0; t < k; ++t) {
+            atom * a = (*cla)[pos[t]];
+            if (!is_changed_var(a->x()))
+                continue;
+            lbool res = value(a, c);
+            if (res == l_true) {
+                satisfied = true;
+                break;
+            }
+            if (res == l_false)
+                ++false_cnt;
+        }
+        reduced += satisfied ? k : false_cnt;
+    }
+    unmark_changed_vars();
+    return reduced;
+}
+
+unsigned context_t::var_degree(var x) {
+    definition * d = m_defs[x];
+    if (d == nullptr)
+        return 1;
+    unsigned r = 0;
+    if (d->get_kind() == constraint::MONOMIAL) {
+        monomial * m = get_monomial(x);
+        for (unsigned i = 0, sz = m->size(); i < sz; ++i)
+            r += m->degree(i);
+    }
+    else if (d->get_kind() == constraint::POLYNOMIAL) {
+        polynomial * p = get_polynomial(x);
+        for (unsigned i = 0, sz = p->size(); i < sz; ++i) {
+            var y = p->x(i);
+            unsigned dy = 1;
+            if (m_defs[y] != nullptr && m_defs[y]->get_kind() == constraint::MONOMIAL) {
+                monomial * m = get_monomial(y);
+                dy = 0;
+                for (unsigned j = 0, msz = m->size(); j < msz; ++j)
+                    dy += m->degree(j);
+            }
+            r = std::max(r, dy);
+        }
+    }
+    return r;
+}
+
+void context_t::estimate_task(node * c, unsigned & undef_clauses, unsigned & undef_lits) {
+    node * p = c->parent();
+    undef_clauses = 0;
+    undef_lits = 0;
+    bool use_residual = p != nullptr && p->id() < m_task_residuals.size() && m_task_residual_valid[p->id()];
+    bool use_features = m_hardness_model != nullptr;
+    double deg_sum = 0.0;
+    unsigned deg_max = 0;
+    if (p != nullptr && !use_residual) {
+        // no residual, keep the size of the task of the parent
+        undef_clauses = m_ptask->m_undef_clause_num;
+        undef_lits = m_ptask->m_undef_lit_num;
+    }
+    else {
+        if (use_residual)
+            mark_changed_vars(c, p);
+        unsigned_vector const * residual = use_residual ? &m_task_residuals[p->id()] : nullptr;
+        unsigned i = 0;
+        unsigned isz = use_residual ? residual->size() : m_clauses.size();
+        while (i < isz) {
+            clause * cla;
+            unsigned k;
+            unsigned const * pos;
+            if (use_residual) {
+                cla = m_clauses[(*residual)[i]];
+                k   = (*residual)[i + 1];
+                pos = residual->data() + i + 2;
+                i  += 2 + k;
+            }
+            else {
+                cla = m_clauses[i];
+                k   = cla->m_size;
+                pos = nullptr;
+                i++;
+            }
+            unsigned num_undef = 0;
+            bool satisfied = false;
+            for (unsigned t = 0; t < k; ++t) {
+                atom * a = (*cla)[pos != nullptr ? pos[t] : t];
+                lbool res = (!use_residual || is_changed_var(a->x())) ? value(a, c) : l_undef;
+                if (res == l_true) {
+                    satisfied = true;
+                    break;
+                }
+                if (res == l_false)
+                    continue;
+                ++num_undef;
+                if (use_features && !a->is_bool()) {
+                    unsigned d = var_degree(a->x());
+                    deg_sum += d;
+                    deg_max = std::max(deg_max, d);
+                }
+            }
+            // clauses reduced to a single literal become variable bounds of the task
+            if (!satisfied && num_undef > 1) {
+                ++undef_clauses;
+                undef_lits += num_undef;
+            }
+        }
+        if (use_residual)
+            unmark_changed_vars();
+    }
+    if (!use_features)
+        return;
+    unsigned id = c->id();
+    if (m_node_features.size() <= id)
+        m_node_features.resize(id + 1, hardness_features());
+    hardness_features & f = m_node_features[id];
+    f.reset();
+    f[hardness_features::DEPTH]          = c->depth();
+    f[hardness_features::UNDEF_CLAUSES]  = std::log1p(static_cast<double>(undef_clauses));
+    f[hardness_features::UNDEF_LITS]     = std::log1p(static_cast<double>(undef_lits));
+    if (undef_clauses > 0)
+        f[hardness_features::AVG_CLAUSE_LEN] = static_cast<double>(undef_lits) / undef_clauses;
+    if (undef_lits > 0)
+        f[hardness_features::AVG_DEGREE] = deg_sum / undef_lits;
+    f[hardness_features::MAX_DEGREE]     = deg_max;
+    unsigned num_arith = 0, num_unbounded = 0, num_bounded = 0;
+    double width_sum = 0.0;
+    scoped_mpq w(nm());
+    for (var x = 0, sz = num_vars(); x < sz; ++x) {
+        if (m_is_bool[x] || m_defs[x] != nullptr)
+            continue;
+        ++num_arith;
+        bound * l = c->lower(x);
+        bound * u = c->upper(x);
+        if (l == nullptr || u == nullptr) {
+            ++num_unbounded;
+            continue;
+        }
+        nm().sub(u->value(), l->value(), w);
+        width_sum += std::log1p(std::max(nm().get_double(w), 0.0));
+        ++num_bounded;
+    }
+    if (num_arith > 0)
+        f[hardness_features::UNBOUNDED_VARS] = static_cast<double>(num_unbounded) / num_arith;
+    if (num_bounded > 0)
+        f[hardness_features::LOG_WIDTH] = width_sum / num_bounded;
+    unsigned num_new_bounds = 0;
+    bound * b_old = c->parent_trail_stack();
+    for (bound * b = c->trail_stack(); b != b_old; b = b->prev())
+        ++num_new_bounds;
+    f[hardness_features::PROP_YIELD]     = std::log1p(static_cast<double>(num_new_bounds));
+}
+
+void context_t::push_leaf(node * c) {
+    unsigned undef_clauses, undef_lits;
+    estimate_task(c, undef_clauses, undef_lits);
+    double hardness = 0.0;
+    if (m_hardness_model != nullptr)
+        hardness = m_hardness_model->predict(m_node_features[c->id()]);
+    m_leaf_heap.emplace(c->id(), c->depth(), undef_clauses, undef_lits, hardness);
+}
+
+void context_t::observe_solving_time(unsigned id, double time, bool completed) {
+    if (m_hardness_model == nullptr || id >= m_node_features.size())
+        return;
+    hardness_features const & f = m_node_features[id];
+    // a terminated task only shows that the node is at least that hard
+    if (!completed && m_hardness_model->predict(f) >= time)
+        return;
+    m_hardness_model->update(f, time);
+    ++m_num_hardness_updates;
+}
+
+double context_t::lookahead_side(node * n, var x, numeral const & mid, bool lower, bool open) {
+    scoped_mpq nmid(nm());
+    normalize_bound(x, mid, nmid, lower, open);
+    node * c = mk_node(n);
+    bound * b = mk_bound(x, nmid, lower, open, c, justification());
+    m_queue.push_back(b);
+    propagate(c);
+    double score;
+    if (c->inconsistent())
+        // a conflict removes every literal of the task
+        score = 1.0 + m_ptask->m_undef_lit_num;
+    else
+        score = 1.0 + count_reduced_lits(c);
+    // c is the last created node, so its id can be reused.
+    del_node(c);
+    m_nodes.pop_back();
+    m_nodes_state.pop_back();
+    return score;
+}
+
+void context_t::lookahead(node * n) {
+    unsigned sz = m_lookahead_vars.size();
+    if (sz < 2)
+        return;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    m_in_lookahead = true;
+    var best = null_var;
+    double best_score = 0.0;
+    bool best_lower = false, best_open = false;
+    vector<lit> x_lits;
+    scoped_mpq mid(nm());
+    for (unsigned i = 0; i < sz; ++i) {
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+        if (elapsed > m_lookahead_ms)
+            break;
+        var x = m_lookahead_vars[i].second;
+        if (!calc_var_info(n, x, m_curr_var_info))
+            continue;
+        bool blower, bopen;
+        x_lits.reset();
+        collect_split_lits(x, x_lits);
+        try {
+            select_split_bound(n, x, m_curr_var_info.m_cz, x_lits, mid, blower, bopen);
+        }
+        catch (subpaving::exception &) {
+            continue;
+        }
+        // product of the reductions of both sides, which favors balanced splits
+        double score = lookahead_side(n, x, mid, blower, bopen) 
+                     * lookahead_side(n, x, mid, !blower, !bopen);
+        m_num_lookahead_probes++;
+        {
+            m_temp_stringstream << "lookahead var-" << x << ", score: " << score;
+            write_debug_ss_line_to_coordinator();
+        }
+        if (best == null_var || score > best_score) {
+            best = x;
+            best_score = score;
+            best_lower = blower;
+            best_open = bopen;
+            nm().set(m_lookahead_mid, mid);
+        }
+    }
+    m_in_lookahead = false;
+    if (best == null_var)
+        return;
+    if (best != m_best_var_info.m_id) {
+        m_num_lookahead_changes++;
+        calc_var_info(n, best, m_best_var_info);
+    }
+    m_lookahead_lower = best_lower;
+    m_lookahead_open = best_open;
+    m_lookahead_bound_ready = true;
+}
+
+void context_t::need_lemma_bounds(var x) {
+    for (unsigned k = 0; k < 2; ++k) {
+        unsigned idx = 2 * x + k;
+        if (!m_lemma_need[idx]) {
+            m_lemma_need[idx] = true;
+            m_lemma_need_idxs.push_back(idx);
+        }
+    }
+}
+
+void context_t::need_jst_bounds(bound * b) {
+    var tx = b->x();
+    justification jst = b->jst();
+    if (jst.is_clause()) {
+        // the other atoms of the clause were false
+        clause * c = jst.get_clause();
+        unsigned sz = c->size();
+        unsigned num_tx = 0;
+        for (unsigned i = 0; i < sz; ++i) {
+            if ((*c)[i]->x() == tx)
+                ++num_tx;
+        }
+        for (unsigned i = 0; i < sz; ++i) {
+            var y = (*c)[i]->x();
+            if (y != tx || num_tx > 1)
+                need_lemma_bounds(y);
+        }
+    }
+    else {
+        SASSERT(jst.is_var_def());
+        var x = jst.get_var();
+        definition * d = m_defs[x];
+        // monomial propagation may also use the old bounds of the target variable
+        bool skip_tx = d->get_kind() == constraint::POLYNOMIAL;
+        if (x != tx || !skip_tx)
+            need_lemma_bounds(x);
+        if (d->get_kind() == constraint::MONOMIAL) {
+            monomial * m = static_cast<monomial*>(d);
+            for (unsigned i = 0, sz = m->size(); i < sz; ++i)
+                need_lemma_bounds(m->x(i));
+        }
+        else {
+            polynomial * p = static_cast<polynomial*>(d);
+            for (unsigned i = 0, sz = p->size(); i < sz; ++i) {
+                if (p->x(i) != tx)
+                    need_lemma_bounds(p->x(i));
+            }
+        }
+    }
+}
+
+void context_t::learn_lemma(node * n) {
+    SASSERT(inconsistent(n));
+    m_lemma_need.resize(2 * num_vars(), false);
+    need_lemma_bounds(n->get_conflict_var());
+    unsigned num_needs = m_lemma_need_idxs.size();
+    ptr_buffer<bound> decisions;
+    // Walk the bounds of n from the newest one. The latest bound on (x, kind) older than
+    // the bounds needing it is the one that was used, since bounds only get tighter.
+    bound * root_trail = m_root->trail_stack();
+    for (bound * b = n->trail_stack(); b != root_trail && num_needs > 0; b = b->prev()) {
+        unsigned idx = 2 * b->x() + b->is_lower();
+        if (!m_lemma_need[idx])
+            continue;
+        m_lemma_need[idx] = false;
+        --num_needs;
+        if (b->jst().is_axiom() || b->jst().is_assumption()) {
+            decisions.push_back(b);
+        }
+        else {
+            unsigned old_sz = m_lemma_need_idxs.size();
+            need_jst_bounds(b);
+            num_needs += m_lemma_need_idxs.size() - old_sz;
+        }
+    }
+    for (unsigned idx : m_lemma_need_idxs)
+        m_lemma_need[idx] = false;
+    m_lemma_need_idxs.reset();
+
+    if (decisions.empty()) {
+        // the conflict only depends on the input constraints
+        write_debug_line_to_coordinator("conflict without split bounds at node-" + std::to_string(n->id()));
+        return;
+    }
+    for (bound * b : decisions) {
+        if (m_is_bool[b->x()])
+            return;
+    }
+    ptr_buffer<atom> atoms;
+    for (bound * b : decisions)
+        atoms.push_back(mk_ineq_atom(b->x(), b->value(), !b->is_lower(), !b->is_open()));
+    m_num_lemmas++;
+    if (atoms.size() == 1) {
+        inc_ref(atoms[0]);
+        m_unit_lemmas.push_back(atoms[0]);
+    }
+    else {
+        add_clause_core(atoms.size(), atoms.data(), true, true);
+    }
+    {
+        m_temp_stringstream << "lemma of size " << atoms.size() << " learned at node-" << n->id();
+        write_debug_ss_line_to_coordinator();
+    }
+}
+
+void context_t::propagate_new_lemmas(node * n) {
+    node * p = n->parent();
+    for (unsigned i = p->num_unit_lemmas(), sz = m_unit_lemmas.size(); i < sz && !inconsistent(n); ++i) {
+        atom * a = m_unit_lemmas[i];
+        // unit lemmas are asserted as split bounds, the lemmas depending on them stay valid
+        propagate_bound(a->x(), a->value(), a->is_lower(), a->is_open(), n, justification());
+    }
+    for (unsigned i = p->num_lemmas(), sz = m_lemmas.size(); i < sz && !inconsistent(n); ++i) {
+        try {
+            propagate_clause(m_lemmas[i], n);
+        }
+        catch (const typename config_mpq::exception &) {
+            // arithmetic module failed, ignore constraint
+            set_arith_failed();
+        }
+    }
+    n->set_num_lemmas(m_lemmas.size(), m_unit_lemmas.size());
+}
+
+void context_t::split_node(node * n) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    split_node_core(n);
+    m_num_split_nodes++;
+    m_split_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void context_t::split_node_core(node * n) {
+    if (split_imported_node(n))
+        return;
+    select_best_var(n);
+    if (m_lookahead > 0)
+        lookahead(n);
+    unsigned id = m_best_var_info.m_id;
+    if (id == null_var) {
+        write_debug_line_to_coordinator("no split var is selected");
+        return;
+    }
+    write_debug_line_to_coordinator("best var: " + m_best_var_info.to_string());
+    TRACE("linxi_subpaving", 
+        var x = id;
+        tout << "best var interval: " << x << "\n";
+        bound * l = n->lower(x);
+        bound * u = n->upper(x);
+        if (l != nullptr) {
+            display(tout, l);
+            tout << " ";
+        }
+        if (u != nullptr) {
+            display(tout, u);
+        }
+        if (l != nullptr || u != nullptr)
+            tout << "\n";
+    );
+    bool blower, bopen;
+    // numeral & mid = m_tmp1;
+    scoped_mpq mid(nm());
+
+    vector<lit> x_lits;
+    collect_split_lits(id, x_lits);
+
+    unsigned x_lits_sz = x_lits.size();
+    {
+        m_temp_stringstream << "x_lits_sz: " << x_lits_sz;
+        write_debug_ss_line_to_coordinator();
+        
+        m_temp_stringstream << "split var-"<< id;
+        write_debug_ss_line_to_coordinator();
+
+        bound * lb = n->lower(id);
+        m_temp_stringstream << "x_lower: ";
+        if (lb == nullptr) {
+            m_temp_stringstream << "null";
+        }
+        else {
+            display(m_temp_stringstream, lb);
+        }
+        write_debug_ss_line_to_coordinator();
+
+        bound * ub = n->upper(id);
+        m_temp_stringstream << "x_upper: ";
+        if (ub == nullptr) {
+            m_temp_stringstream << "null";
+        }
+        else {
+            display(m_temp_stringstream, ub);
+        }
+        write_debug_ss_line_to_coordinator();
+    }
+
+    // {
+    //     var vid = 1856;
+    //     m_temp_stringstream << "var-"<< vid;
+    //     write_debug_ss_line_to_coordinator();
+
+    //     bound * lb = n->lower(vid);
+    //     m_temp_stringstream << "x_lower: ";
+    //     if (lb == nullptr) {
+    //         m_temp_stringstream << "null";
+    //     }
+    //     else {
+    //         display(m_temp_stringstream, lb);
+    //     }
+    //     write_debug_ss_line_to_coordinator();
+
+    //     bound * ub = n->upper(vid);
+    //     m_temp_stringstream << "x_upper: ";
+    //     if (ub == nullptr) {
+    //         m_temp_stringstream << "null";
+    //     }
+    //     else {
+    //         display(m_temp_stringstream, ub);
+    //     }
+    //     write_debug_ss_line_to_coordinator();
+    // }
+
+    if (m_lookahead_bound_ready) {
+        // the split bound was already selected by the lookahead
+        nm().set(mid, m_lookahead_mid);
+        blower = m_lookahead_lower;
+        bopen = m_lookahead_open;
+        m_lookahead_bound_ready = false;
+    }
+    else {
+        select_split_bound(n, id, m_best_var_info.m_cz, x_lits, mid, blower, bopen);
+    }
+    split_node_at(n, id, mid, blower, bopen);
+}
+
+void context_t::split_node_at(node * n, var id, numeral const & mid, bool blower, bool bopen) {
+    node * left   = this->mk_node(n);
+    node * right  = this->mk_node(n);
+    
+    // ++m_var_split_cnt[id];
+    // m_var_split_prob[id] *= m_split_prob_decay;
+    left->set_split_var(id);
+    right->set_split_var(id);
+    journal_record r(journal_record::SPLIT, n->id());
+    r.m_left  = left->id();
+    r.m_right = right->id();
+    r.m_var   = id;
+    r.m_lower = blower;
+    r.m_open  = bopen;
+    r.m_draws = m_rand.draws();
+    r.m_text  = nm().to_string(mid);
+    journal(r);
+
     // numeral & nmid = m_tmp2;
     scoped_mpq nmid(nm());
     bool nlower = blower, nopen = bopen;
@@ -3768,18 +5368,20 @@ void context_t::split_node(node * n) {
             write_debug_ss_line_to_coordinator();
         }
         TRACE("subpaving_main", tout << "node #" << left->id() << " is inconsistent.\n";);
+        if (m_learn_lemmas)
+            learn_lemma(left);
         m_temp_stringstream << control_message::P2C::new_unsat_node 
                             << " " << left->id() << " " << n->id();
         write_ss_line_to_coordinator();
+        journal(journal_record(journal_record::UNSAT, left->id()));
         remove_from_leaf_dlist(left);
-        m_nodes_state[left->id()] = node_state::UNSAT;
+        set_node_state(left->id(), node_state::UNSAT);
     }
     else {
-        m_leaf_heap.emplace(left->id(), m_ptask->m_depth, 
-            m_ptask->m_undef_clause_num, m_ptask->m_undef_lit_num);
+        push_leaf(left);
         ++m_unsolved_task_num;
-        for (unsigned i = 0, sz = left->depth(); i < sz; ++i)
-            ++m_var_unsolved_split_cnt[left->split_vars()[i]];
+        for (node * a = left; a->depth() > 0; a = a->parent())
+            ++m_var_unsolved_split_cnt[a->split_var()];
     }
 
     nlower = !blower, nopen = !bopen;
@@ -3800,19 +5402,23 @@ void context_t::split_node(node * n) {
         //     write_debug_ss_line_to_coordinator();
         // }
         TRACE("subpaving_main", tout << "node #" << right->id() << " is inconsistent.\n";);
+        if (m_learn_lemmas)
+            learn_lemma(right);
         m_temp_stringstream << control_message::P2C::new_unsat_node 
                             << " " << right->id() << " " << n->id();
         write_ss_line_to_coordinator();
+        journal(journal_record(journal_record::UNSAT, right->id()));
         remove_from_leaf_dlist(right);
-        m_nodes_state[right->id()] = node_state::UNSAT;
+        set_node_state(right->id(), node_state::UNSAT);
     }
     else {
-        m_leaf_heap.emplace(right->id(), m_ptask->m_depth, 
-            m_ptask->m_undef_clause_num, m_ptask->m_undef_lit_num);
+        push_leaf(right);
         ++m_unsolved_task_num;
-        for (unsigned i = 0, sz = right->depth(); i < sz; ++i)
-            ++m_var_unsolved_split_cnt[right->split_vars()[i]];
+        for (node * a = right; a->depth() > 0; a = a->parent())
+            ++m_var_unsolved_split_cnt[a->split_var()];
     }
+    // both children visited the pending watches of n
+    n->pending_watch_vars().finalize();
 }
 
 bool context_t::create_new_task() {
@@ -3823,15 +5429,17 @@ bool context_t::create_new_task() {
         if (m_leaf_heap.empty())
             break;
         node * n = select_next_node();
+        if (n == nullptr)
+            continue; // collected
         TRACE("subpaving_main", tout << "selected node: #" << n->id() << ", depth: " << n->depth() << "\n";);
         if (n->inconsistent()) {
-            m_nodes_state[n->id()] = node_state::UNSAT;
+            set_node_state(n->id(), node_state::UNSAT);
             continue;
         }
         if (m_nodes_state[n->id()] != node_state::UNCONVERTED)
             continue;
         if (n->parent() != nullptr && m_nodes_state[n->parent()->id()] == node_state::UNSAT) {
-            m_nodes_state[n->id()] = node_state::UNSAT;
+            set_node_state(n->id(), node_state::UNSAT);
             continue;
         }
         TRACE("subpaving_main", tout << "node #" << n->id() << " after propagation\n";
@@ -3858,9 +5466,25 @@ bool context_t::create_new_task() {
             m_temp_stringstream << control_message::P2C::new_unsat_node 
                                 << " " << n->id() << " " << pid;
             write_ss_line_to_coordinator();
-            m_nodes_state[n->id()] = node_state::UNSAT;
+            journal(journal_record(journal_record::UNSAT, n->id()));
+            set_node_state(n->id(), node_state::UNSAT);
             continue;
         }
+        // every clause is satisfied by the bounds of a task without clauses,
+        // a model is searched for it in any case
+        bool box_task = m_ptask->m_clauses.empty();
+        if (m_models_enabled && (m_sat_samples > 0 || box_task) &&
+            find_model(n, box_task ? std::max(m_sat_samples, 16u) : m_sat_samples)) {
+            m_found_model = true;
+            m_ptask->reset();
+            m_temp_stringstream << control_message::P2C::sat << " " << n->id();
+            write_ss_line_to_coordinator();
+            {
+                m_temp_stringstream << "node-" << n->id() << " model found in its box, sampled points: " << m_num_sat_samples;
+                write_debug_ss_line_to_coordinator();
+            }
+            return true;
+        }
         // if (m_root_bicp_done) {
         //     convert_node_task_to_task(n);
         // }
@@ -3899,10 +5523,400 @@ bool context_t::create_new_task() {
     return false;
 }
 
+void context_t::journal(journal_record const & r) {
+    if (m_journal.is_open())
+        m_journal.write(r);
+}
+
+uint64_t context_t::input_fingerprint() const {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    auto fnv = [&h](uint64_t v) {
+        h ^= v;
+        h *= 1099511628211ull;
+    };
+    auto fnv_num = [&](numeral const & v) {
+        std::string str = nm().to_string(v);
+        fnv(str.size());
+        for (char ch : str)
+            fnv(static_cast<unsigned char>(ch));
+    };
+    auto fnv_atom = [&](atom * a) {
+        fnv((static_cast<uint64_t>(a->x()) << 2) | (a->is_lower() << 1) | a->is_open());
+        fnv_num(a->value());
+    };
+    fnv(num_vars());
+    fnv(m_rand_seed);
+    for (var x = 0; x < num_vars(); x++) {
+        fnv(is_int(x));
+        definition * d = m_defs[x];
+        if (d == nullptr) {
+            fnv(0);
+            continue;
+        }
+        fnv(d->get_kind());
+        if (d->get_kind() == constraint::MONOMIAL) {
+            monomial * mon = static_cast<monomial*>(d);
+            fnv(mon->size());
+            for (unsigned i = 0; i < mon->size(); i++) {
+                fnv(mon->x(i));
+                fnv(mon->degree(i));
+            }
+        }
+        else {
+            polynomial * p = static_cast<polynomial*>(d);
+            fnv(p->size());
+            for (unsigned i = 0; i < p->size(); i++) {
+                fnv(p->x(i));
+                fnv_num(p->a(i));
+            }
+        }
+    }
+    fnv(m_unit_clauses.size());
+    for (atom * a : m_unit_clauses)
+        fnv_atom(UNTAG(atom*, a));
+    fnv(m_clauses.size());
+    for (clause * c : m_clauses) {
+        fnv(c->size());
+        for (unsigned i = 0, sz = c->size(); i < sz; ++i)
+            fnv_atom((*c)[i]);
+    }
+    return h;
+}
+
+void context_t::init_journal() {
+    const params_ref &p = gparams::get_ref();
+    std::string snapshot_path = p.get_str("partition_snapshot", "");
+    std::string restore_path = p.get_str("partition_restore", "");
+    uint64_t fingerprint = input_fingerprint();
+    std::vector<journal_record> records;
+    if (!restore_path.empty()) {
+        std::string err;
+        if (!tree_journal::read(restore_path, fingerprint, records, err)) {
+            write_debug_line_to_coordinator("the tree is not restored: " + err);
+            records.clear();
+        }
+    }
+    // the journal is read before it is overwritten, both may be the same file
+    if (!snapshot_path.empty() && !m_journal.open(snapshot_path, fingerprint))
+        write_debug_line_to_coordinator("cannot write the journal " + snapshot_path);
+    if (!records.empty())
+        replay_journal(records);
+}
+
+void context_t::replay_journal(std::vector<journal_record> const & records) {
+    m_replaying = true;
+    unsigned num_replayed = 0;
+    scoped_mpq mid(nm());
+    for (journal_record const & r : records) {
+        if (r.m_kind == journal_record::SPLIT) {
+            if (r.m_left != m_nodes.size() || r.m_right != r.m_left + 1) {
+                write_debug_line_to_coordinator("the journal does not match the tree");
+                break;
+            }
+            node * n = r.m_node < m_nodes.size() ? m_nodes[r.m_node] : nullptr;
+            if (n == nullptr || n->inconsistent() || n->first_child() != nullptr || r.m_var >= num_vars()) {
+                // the parent is unsat in this process, only the ids of the children are reserved
+                journal(r);
+                for (unsigned i = 0; i < 2; ++i) {
+                    m_nodes.push_back(nullptr);
+                    m_nodes_state.push_back(node_state::UNSAT);
+                }
+            }
+            else {
+                if (r.m_draws > m_rand.draws())
+                    m_rand.discard(r.m_draws - m_rand.draws());
+                nm().set(mid, r.m_text.c_str());
+                split_node_at(n, r.m_var, mid, r.m_lower, r.m_open);
+            }
+        }
+        else if (r.m_kind == journal_record::MESSAGE) {
+            journal(r);
+            parse_line(r.m_text);
+        }
+        else if (r.m_node < m_nodes.size() && m_nodes[r.m_node] != nullptr &&
+                 m_nodes_state[r.m_node] == node_state::UNCONVERTED) {
+            journal(r);
+            if (r.m_kind == journal_record::TASK) {
+                // the coordinator still has the task of the node
+                m_nodes_state[r.m_node] = node_state::WAITING;
+                ++m_alive_task_num;
+                m_root_bicp_done = true;
+            }
+            else {
+                set_node_state(r.m_node, node_state::UNSAT);
+            }
+        }
+        ++num_replayed;
+    }
+    m_replaying = false;
+    {
+        m_temp_stringstream << "replayed journal records: " << num_replayed << "/" << records.size()
+            << ", nodes: " << m_nodes.size() << ", alive tasks: " << m_alive_task_num;
+        write_debug_ss_line_to_coordinator();
+    }
+    // the previous partitioner may have stopped between announcing a task and splitting its node
+    for (unsigned id = 0, sz = m_nodes.size(); id < sz; ++id) {
+        node * n = m_nodes[id];
+        if (n != nullptr && m_nodes_state[id] == node_state::WAITING &&
+            n->first_child() == nullptr && !n->inconsistent())
+            split_node(n);
+    }
+}
+
+std::string context_t::var_name(var x) const {
+    std::ostringstream ss;
+    (*m_display_proc)(ss, x);
+    // the layout of the pretty printer is ignored
+    std::string name;
+    bool space = false;
+    for (char c : ss.str()) {
+        if (isspace(static_cast<unsigned char>(c))) {
+            space = !name.empty();
+            continue;
+        }
+        if (space)
+            name.push_back(' ');
+        space = false;
+        name.push_back(c);
+    }
+    return name;
+}
+
+void context_t::export_subtree(unsigned id, std::string const & path) {
+    node * r = id < m_nodes.size() ? m_nodes[id] : nullptr;
+    if (r != nullptr && m_nodes_state[id] != node_state::UNSAT) {
+        std::ofstream out(path);
+        out << "; subtree of node-" << id << "\n";
+        unsigned num_exported = 1, num_splits = 0;
+        vector<std::pair<node *, unsigned>> todo;
+        todo.push_back(std::make_pair(r, 0u));
+        while (!todo.empty()) {
+            node * n = todo.back().first;
+            unsigned sub_id = todo.back().second;
+            todo.pop_back();
+            // the sibling of c is missing if it was collected
+            node * c = n->first_child();
+            if (c == nullptr)
+                continue;
+            var x = c->split_var();
+            // the split bound is the first bound of c
+            bound * b = nullptr;
+            bound * b_old = c->parent_trail_stack();
+            for (bound * curr = c->trail_stack(); curr != b_old; curr = curr->prev()) {
+                if (curr->x() == x)
+                    b = curr;
+            }
+            if (b == nullptr)
+                continue;
+            unsigned first = num_exported++;
+            unsigned second = num_exported++;
+            out << "split " << sub_id << " " << first << " " << second << " " << b->is_lower() << " " << b->is_open()
+                << " " << nm().to_string(b->value()) << " " << var_name(x) << "\n";
+            ++num_splits;
+            node * children[2] = { c, c->next_sibling() };
+            unsigned sub_ids[2] = { first, second };
+            for (unsigned i = 0; i < 2; ++i) {
+                node * ch = children[i];
+                if (ch == nullptr || ch->inconsistent() || m_nodes_state[ch->id()] == node_state::UNSAT)
+                    out << "unsat " << sub_ids[i] << "\n";
+                else
+                    todo.push_back(std::make_pair(ch, sub_ids[i]));
+            }
+        }
+        m_temp_stringstream << "exported subtree of node-" << id << ", splits: " << num_splits;
+        write_debug_ss_line_to_coordinator();
+    }
+    m_temp_stringstream << control_message::P2C::subtree_exported << " " << id;
+    write_ss_line_to_coordinator();
+}
+
+void context_t::import_subtree() {
+    const params_ref &p = gparams::get_ref();
+    std::string path = p.get_str("partition_import", "");
+    if (path.empty())
+        return;
+    std::ifstream in(path);
+    if (!in) {
+        write_debug_line_to_coordinator("cannot read the subtree " + path);
+        return;
+    }
+    std::unordered_map<std::string, var> vars;
+    for (var x = 0, sz = num_vars(); x < sz; ++x)
+        vars.emplace(var_name(x), x);
+    unsigned num_dropped = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::string kind;
+        ss >> kind;
+        if (kind == "split") {
+            imported_split s;
+            unsigned sub_id, lower, open;
+            std::string name;
+            if (!(ss >> sub_id >> s.m_first >> s.m_second >> lower >> open >> s.m_value) ||
+                !std::getline(ss >> std::ws, name)) {
+                ++num_dropped;
+                continue;
+            }
+            auto it = vars.find(name);
+            if (it == vars.end()) {
+                // the subtree of the node is not imported
+                ++num_dropped;
+                continue;
+            }
+            s.m_var   = it->second;
+            s.m_lower = lower != 0;
+            s.m_open  = open != 0;
+            unsigned max_id = std::max(sub_id, std::max(s.m_first, s.m_second));
+            if (m_import_split_of.size() <= max_id)
+                m_import_split_of.resize(max_id + 1, 0);
+            m_imported_splits.push_back(s);
+            m_import_split_of[sub_id] = m_imported_splits.size();
+        }
+        else if (kind == "unsat") {
+            unsigned sub_id;
+            if (!(ss >> sub_id))
+                continue;
+            if (m_import_unsat.size() <= sub_id)
+                m_import_unsat.resize(sub_id + 1, false);
+            m_import_unsat[sub_id] = true;
+        }
+    }
+    {
+        m_temp_stringstream << "imported splits: " << m_imported_splits.size() << ", dropped: " << num_dropped;
+        write_debug_ss_line_to_coordinator();
+    }
+    attach_import(0, m_root);
+}
+
+void context_t::attach_import(unsigned sub_id, node * n) {
+    if (sub_id >= m_import_split_of.size() || m_import_split_of[sub_id] == 0)
+        return;
+    if (m_node_import.size() <= n->id())
+        m_node_import.resize(n->id() + 1, 0);
+    m_node_import[n->id()] = m_import_split_of[sub_id];
+}
+
+bool context_t::load_root_bounds() {
+    if (m_root_cache.empty())
+        return false;
+    std::ifstream in(m_root_cache);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != "; root bounds " + std::to_string(num_vars()))
+        return false;
+    unsigned num_loaded = 0;
+    scoped_mpq value(nm());
+    while (std::getline(in, line) && !inconsistent(m_root)) {
+        std::istringstream ss(line);
+        std::string kind, val;
+        unsigned open = 0;
+        var x;
+        if (!(ss >> kind))
+            continue;
+        bool is_bool = kind == "bool";
+        if (!is_bool && kind != "lower" && kind != "upper")
+            continue;
+        if ((!is_bool && !(ss >> open)) || !(ss >> val >> x))
+            continue;
+        if (x >= num_vars() || is_bool != m_is_bool[x] || is_definition(x))
+            continue;
+        if (is_bool)
+            propagate_bvar_bound(x, val == "0", m_root, justification());
+        else {
+            nm().set(value, val.c_str());
+            propagate_bound(x, value, kind == "lower", open != 0, m_root, justification());
+        }
+        ++num_loaded;
+    }
+    m_temp_stringstream << "root bounds loaded from " << m_root_cache << ": " << num_loaded;
+    write_debug_ss_line_to_coordinator();
+    return true;
+}
+
+void context_t::save_root_bounds() {
+    if (m_root_cache.empty())
+        return;
+    // written under a temporary name, partitioners on the same goal may start together
+    std::string tmp = m_root_cache + ".tmp" + std::to_string(getpid());
+    bool written;
+    {
+        std::ofstream out(tmp);
+        out << "; root bounds " << num_vars() << "\n";
+        for (var x = 0, sz = num_vars(); x < sz; ++x) {
+            // the bounds of definitions are derived again, tasks only carry those implied by clauses
+            if (is_definition(x))
+                continue;
+            if (m_is_bool[x]) {
+                bvalue_kind bk = m_root->bvalue(x);
+                if (bk == b_true || bk == b_false)
+                    out << "bool " << (bk == b_true) << " " << x << "\n";
+                continue;
+            }
+            bound * bs[2] = { m_root->lower(x), m_root->upper(x) };
+            for (bound * b : bs) {
+                if (b != nullptr)
+                    out << (b->is_lower() ? "lower " : "upper ") << b->is_open() << " "
+                        << nm().to_string(b->value()) << " " << x << "\n";
+            }
+        }
+        written = static_cast<bool>(out);
+    }
+    if (!written || std::rename(tmp.c_str(), m_root_cache.c_str()) != 0)
+        std::remove(tmp.c_str());
+}
+
+bool context_t::split_imported_node(node * n) {
+    unsigned id = n->id();
+    if (id >= m_node_import.size() || m_node_import[id] == 0)
+        return false;
+    imported_split s = m_imported_splits[m_node_import[id] - 1];
+    m_node_import[id] = 0;
+    write_debug_line_to_coordinator("imported split of node-" + std::to_string(id) + ": " + var_name(s.m_var));
+    scoped_mpq value(nm());
+    nm().set(value, s.m_value.c_str());
+    unsigned first_id = m_nodes.size();
+    split_node_at(n, s.m_var, value, s.m_lower, s.m_open);
+    unsigned sub_ids[2] = { s.m_first, s.m_second };
+    for (unsigned i = 0; i < 2; ++i) {
+        unsigned cid = first_id + i;
+        // inconsistent children are already reported by split_node_at
+        if (m_nodes_state[cid] != node_state::UNCONVERTED)
+            continue;
+        if (sub_ids[i] < m_import_unsat.size() && m_import_unsat[sub_ids[i]]) {
+            m_temp_stringstream << control_message::P2C::new_unsat_node 
+                                << " " << cid << " " << id;
+            write_ss_line_to_coordinator();
+            journal(journal_record(journal_record::UNSAT, cid));
+            set_node_state(cid, node_state::UNSAT);
+        }
+        else {
+            attach_import(sub_ids[i], m_nodes[cid]);
+        }
+    }
+    return true;
+}
+
+void context_t::write_unknown_node_line(unsigned id, int pid) {
+    if (m_ptask->m_buffer_length > 0) {
+        // the task is in the shared task buffer, not in task-<id>.smt2
+        m_temp_stringstream << control_message::P2C::task_buffer
+                            << " " << id << " " << m_ptask->m_buffer_offset << " " << m_ptask->m_buffer_length;
+        write_ss_line_to_coordinator();
+    }
+    m_temp_stringstream << control_message::P2C::new_unknown_node 
+                        << " " << id << " " << pid;
+    // predicted difficulty (solving time in seconds)
+    if (m_hardness_model != nullptr && id < m_node_features.size())
+        m_temp_stringstream << " " << m_hardness_model->predict(m_node_features[id]);
+    write_ss_line_to_coordinator();
+}
+
 // BICP and arithmetic partitioning start here
 lbool context_t::operator()() {
     TRACE("linxi_subpaving", tout << "operator()\n");
     if (!m_init) {
+        std::chrono::steady_clock::time_point root_start = std::chrono::steady_clock::now();
         init_partition();
         init();
         if (m_root->inconsistent()) {
@@ -3910,14 +5924,20 @@ lbool context_t::operator()() {
             remove_from_leaf_dlist(m_root);
             return l_false;
         }
+        bool cached = load_root_bounds();
         propagate(m_root);
         if (m_root->inconsistent()) {
             // unsat
             remove_from_leaf_dlist(m_root);
             return l_false;
         }
-        m_leaf_heap.emplace(0, 0, 0, 0);
+        if (!cached)
+            save_root_bounds();
+        m_root_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - root_start).count();
+        push_leaf(m_root);
         ++m_unsolved_task_num;
+        init_journal();
+        import_subtree();
         // for (unsigned i = 0, sz = m_root->depth(); i < sz; ++i)
         //     ++m_var_unsolved_split_cnt[m_root->split_vars()[i]];
     }
@@ -3929,24 +5949,29 @@ lbool context_t::operator()() {
         int pid = -1;
         if (pa != nullptr)
             pid = static_cast<int>(pa->id());
-        m_temp_stringstream << control_message::P2C::new_unknown_node 
-                            << " " << nid << " " << pid;
-        write_ss_line_to_coordinator();
         m_nodes_state[nid] = node_state::WAITING;
+        journal(journal_record(journal_record::TASK, nid));
         // ++m_unsolved_task_num;
         // for (unsigned i = 0, sz = n->depth(); i < sz; ++i)
         //     ++m_var_unsolved_split_cnt[n->split_vars()[i]];
-        split_node(m_nodes[nid]);
+        write_unknown_node_line(nid, pid);
+        // the task can be solved while n is split
+        flush_lines_to_coordinator();
+        split_node(n);
         m_ptask->reset();
     }
 
     while (true) {
         communicate_with_coordinator();
+        collect_garbage();
         if (m_alive_task_num > m_max_alive_tasks) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // woken up by the next message of the coordinator
+            wait_for_coordinator(100);
             continue;
         }
-        if (create_new_task()) {
+        bool created = create_new_task();
+        flush_lines_to_coordinator();
+        if (created) {
             return l_true;
         }
         else {
@@ -3987,6 +6012,26 @@ void context_t::reset_statistics() {
     m_num_mk_bounds = 0;
     m_num_splits    = 0;
     m_num_visited   = 0;
+    m_num_watch_moves = 0;
+    m_num_fp_filtered = 0;
+    m_num_prop_exhausted = 0;
+    m_num_pending_watch_vars = 0;
+    m_num_prop_extended = 0;
+    m_num_prop_work = 0;
+    m_num_lookahead_probes = 0;
+    m_num_lookahead_changes = 0;
+    m_num_lemmas = 0;
+    m_num_collected_nodes = 0;
+    m_num_hardness_updates = 0;
+    m_num_lp_checks = 0;
+    m_num_lp_refuted = 0;
+    m_num_sat_samples = 0;
+    m_num_split_nodes = 0;
+    m_num_converted_nodes = 0;
+    m_root_time = 0;
+    m_prop_time = 0;
+    m_split_time = 0;
+    m_convert_time = 0;
 }
 
 void context_t::collect_statistics(statistics & st) const {
@@ -3995,6 +6040,26 @@ void context_t::collect_statistics(statistics & st) const {
     st.update("splits",     m_num_splits);
     st.update("nodes",      m_num_nodes);
     st.update("visited",    m_num_visited);
+    st.update("watch moves", m_num_watch_moves);
+    st.update("fp filtered", m_num_fp_filtered);
+    st.update("prop budget exhausted", m_num_prop_exhausted);
+    st.update("pending watch vars", m_num_pending_watch_vars);
+    st.update("prop budget extended", m_num_prop_extended);
+    st.update("prop work", m_num_prop_work);
+    st.update("lookahead probes", m_num_lookahead_probes);
+    st.update("lookahead changes", m_num_lookahead_changes);
+    st.update("lemmas", m_num_lemmas);
+    st.update("collected nodes", m_num_collected_nodes);
+    st.update("hardness updates", m_num_hardness_updates);
+    st.update("lp checks", m_num_lp_checks);
+    st.update("lp refuted", m_num_lp_refuted);
+    st.update("sat samples", m_num_sat_samples);
+    st.update("split nodes", m_num_split_nodes);
+    st.update("converted nodes", m_num_converted_nodes);
+    st.update("root time", m_root_time);
+    st.update("propagation time", m_prop_time);
+    st.update("split time", m_split_time);
+    st.update("convert time", m_convert_time);
 }
 
 // -----------------------------------
@@ -55,6 +55,9 @@ struct task_info {
     unsigned m_undef_clause_num;
     vector<vector<lit>> m_clauses;
     vector<lit> m_var_bounds;
+    // position of the task in the shared task buffer, m_buffer_length is 0 if it was written to a file
+    uint64_t m_buffer_offset;
+    unsigned m_buffer_length;
     
     void reset() {
         m_node_id = UINT32_MAX;
@@ -62,6 +65,8 @@ struct task_info {
         m_var_bounds.reset();
         m_undef_lit_num = 0;
         m_undef_clause_num = 0;
+        m_buffer_offset = 0;
+        m_buffer_length = 0;
     }
 
     void copy(task_info const & src) {
@@ -73,6 +78,8 @@ struct task_info {
         m_clauses.append(src.m_clauses);
         m_var_bounds.reset();
         m_var_bounds.append(src.m_var_bounds);
+        m_buffer_offset = src.m_buffer_offset;
+        m_buffer_length = src.m_buffer_length;
     }
 };
 
@@ -83,12 +90,15 @@ struct control_message {
         new_unsat_node = 2,
         sat = 3,
         unsat = 4,
-        unknown = 5
+        unknown = 5,
+        task_buffer = 6,
+        subtree_exported = 7
     };
 
     enum C2P {
         unsat_node = 0,
-        terminate_node = 1
+        terminate_node = 1,
+        export_subtree = 2
     };
 };
 
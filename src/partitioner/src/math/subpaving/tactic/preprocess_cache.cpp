@@ -0,0 +1,282 @@
+/*++
+Module Name:
+
+    preprocess_cache.cpp
+
+Abstract:
+
+    On-disk cache of the preprocessing of the partitioner, see preprocess_cache.h.
+
+Revision History:
+
+--*/
+#include "math/subpaving/tactic/preprocess_cache.h"
+#include "ast/ast_smt_pp.h"
+#include "ast/arith_decl_plugin.h"
+#include "ast/decl_collector.h"
+#include "ast/converters/generic_model_converter.h"
+#include "ast/rewriter/expr_safe_replace.h"
+#include "ast/rewriter/rewriter_def.h"
+#include "cmd_context/cmd_context.h"
+#include "parsers/smt2/smt2parser.h"
+#include "util/gparams.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace subpaving {
+
+    namespace {
+
+        // bumped when the preprocessing changes, entries of other versions are not found
+        const uint64_t cache_version = 1;
+
+        class fnv_hash {
+            uint64_t m_h = 14695981039346656037ull;
+        public:
+            void add(uint64_t v) {
+                m_h ^= v;
+                m_h *= 1099511628211ull;
+            }
+            void add(std::string const & s) {
+                add(s.size());
+                for (char c : s)
+                    add(static_cast<unsigned char>(c));
+            }
+            uint64_t get() const { return m_h; }
+        };
+
+        // names are hashed by their text, fresh names (k!1) are read back as ordinary symbols
+        void hash_decl(fnv_hash & h, func_decl * d) {
+            h.add(d->get_name().str());
+            h.add(static_cast<uint64_t>(d->get_family_id()));
+            h.add(d->get_decl_kind());
+            h.add(d->get_arity());
+            for (unsigned i = 0, sz = d->get_arity(); i < sz; ++i)
+                h.add(d->get_domain(i)->get_name().str());
+            h.add(d->get_range()->get_name().str());
+            for (parameter const & p : d->parameters()) {
+                if (p.is_int())
+                    h.add(static_cast<uint64_t>(p.get_int()));
+                else if (p.is_rational())
+                    h.add(p.get_rational().to_string());
+                else if (p.is_symbol())
+                    h.add(p.get_symbol().str());
+            }
+        }
+
+        std::string to_hex(uint64_t v) {
+            char buf[17];
+            snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+            return buf;
+        }
+
+        // negative numerals are printed as (- c), they are folded back into numerals
+        struct neg_numeral_cfg : public default_rewriter_cfg {
+            arith_util m_util;
+
+            neg_numeral_cfg(ast_manager & m):m_util(m) {}
+
+            br_status reduce_app(func_decl * f, unsigned num, expr * const * args, expr_ref & result, proof_ref & result_pr) {
+                rational val;
+                bool is_int;
+                if (num != 1 || !m_util.is_uminus(f) || !m_util.is_numeral(args[0], val, is_int))
+                    return BR_FAILED;
+                result = m_util.mk_numeral(-val, is_int);
+                return BR_DONE;
+            }
+        };
+
+        bool parse_goal(ast_manager & m, std::istream & in, goal & g) {
+            cmd_context ctx(false, &m);
+            ctx.set_ignore_check(true);
+            // errors of a damaged entry must not reach the coordinator
+            std::ostringstream err;
+            ctx.set_regular_stream(err);
+            ctx.set_diagnostic_stream(err);
+            if (!parse_smt2_commands(ctx, in))
+                return false;
+            neg_numeral_cfg cfg(m);
+            rewriter_tpl<neg_numeral_cfg> rw(m, false, cfg);
+            expr_ref r(m);
+            for (expr * f : ctx.assertions()) {
+                rw(f, r);
+                g.assert_expr(r);
+            }
+            return true;
+        }
+
+    }
+
+    std::string goal_key(goal const & g) {
+        fnv_hash h;
+        h.add(cache_version);
+        h.add(g.size());
+        // post-order over the DAG, a term is hashed by its declaration and the visit numbers of its arguments
+        obj_map<expr, unsigned> ids;
+        ptr_vector<expr> todo;
+        for (unsigned i = 0, sz = g.size(); i < sz; ++i) {
+            todo.push_back(g.form(i));
+            while (!todo.empty()) {
+                expr * e = todo.back();
+                if (ids.contains(e)) {
+                    todo.pop_back();
+                    continue;
+                }
+                bool visited = true;
+                if (is_app(e)) {
+                    for (expr * arg : *to_app(e)) {
+                        if (!ids.contains(arg)) {
+                            todo.push_back(arg);
+                            visited = false;
+                        }
+                    }
+                }
+                if (!visited)
+                    continue;
+                todo.pop_back();
+                h.add(e->get_kind());
+                if (is_app(e)) {
+                    app * a = to_app(e);
+                    hash_decl(h, a->get_decl());
+                    h.add(a->get_num_args());
+                    for (expr * arg : *a)
+                        h.add(ids[arg]);
+                }
+                else
+                    h.add(e->hash());
+                ids.insert(e, ids.size());
+            }
+            h.add(ids[g.form(i)]);
+        }
+        return to_hex(h.get());
+    }
+
+    namespace {
+
+        class preprocess_cache_tactic : public tactic {
+            ast_manager & m;
+            tactic_ref    m_t;
+
+            // the goal of the entry replaces the formulas of g, the declarations introduced by t are hidden in models
+            bool load(std::string const & path, goal & g) {
+                std::ifstream in(path);
+                std::string line;
+                if (!in || !std::getline(in, line) || line.compare(0, 7, "; goal ") != 0)
+                    return false;
+                goal_ref r = alloc(goal, m, false, g.models_enabled(), false);
+                if (!parse_goal(m, in, *r) || goal_key(*r) != line.substr(7))
+                    return false;
+                if (g.models_enabled()) {
+                    decl_collector input_decls(m);
+                    for (unsigned i = 0, sz = g.size(); i < sz; ++i)
+                        input_decls.visit(g.form(i));
+                    obj_hashtable<func_decl> input;
+                    for (func_decl * d : input_decls.get_func_decls())
+                        input.insert(d);
+                    decl_collector decls(m);
+                    for (unsigned i = 0, sz = r->size(); i < sz; ++i)
+                        decls.visit(r->form(i));
+                    generic_model_converter * mc = alloc(generic_model_converter, m, "preprocess_cache");
+                    for (func_decl * d : decls.get_func_decls()) {
+                        if (!input.contains(d))
+                            mc->hide(d);
+                    }
+                    g.add(mc);
+                }
+                g.reset();
+                for (unsigned i = 0, sz = r->size(); i < sz; ++i)
+                    g.assert_expr(r->form(i));
+                return true;
+            }
+
+            void save(std::string const & path, goal const & g) {
+                std::ostringstream out;
+                ast_smt_pp pp(m);
+                pp.set_benchmark_name("preprocessed");
+                pp.set_simplify_implies(false);
+                // the printer would rename the fresh constants, they get ordinary symbols with the same text
+                expr_ref_vector forms(m);
+                decl_collector decls(m);
+                for (unsigned i = 0, sz = g.size(); i < sz; ++i) {
+                    forms.push_back(g.form(i));
+                    decls.visit(g.form(i));
+                }
+                expr_safe_replace rename(m);
+                for (func_decl * d : decls.get_func_decls()) {
+                    if (d->get_arity() == 0 && d->get_name().is_numerical())
+                        rename.insert(m.mk_const(d), m.mk_const(symbol(d->get_name().str()), d->get_range()));
+                }
+                rename(forms);
+                unsigned sz = forms.size();
+                for (unsigned i = 0; i + 1 < sz; ++i)
+                    pp.add_assumption(forms.get(i));
+                pp.display_smt2(out, sz == 0 ? m.mk_true() : forms.get(sz - 1));
+                std::string text = out.str();
+                std::string key = goal_key(g);
+                {
+                    // only goals that are read back unchanged are cached
+                    goal r(m, false, false, false);
+                    std::istringstream in(text);
+                    if (!parse_goal(m, in, r) || goal_key(r) != key)
+                        return;
+                }
+                std::string tmp = path + ".tmp" + std::to_string(getpid());
+                bool written;
+                {
+                    std::ofstream file(tmp);
+                    file << "; goal " << key << "\n" << text;
+                    written = static_cast<bool>(file);
+                }
+                if (!written || std::rename(tmp.c_str(), path.c_str()) != 0)
+                    std::remove(tmp.c_str());
+            }
+
+        public:
+            preprocess_cache_tactic(ast_manager & m, tactic * t):
+                m(m),
+                m_t(t) {
+            }
+
+            char const * name() const override { return "preprocess_cache"; }
+
+            tactic * translate(ast_manager & m) override {
+                return alloc(preprocess_cache_tactic, m, m_t->translate(m));
+            }
+
+            void operator()(goal_ref const & in, goal_ref_buffer & result) override {
+                const params_ref & p = gparams::get_ref();
+                std::string dir = p.get_str("partition_cache", "");
+                if (dir.empty() || in->proofs_enabled() || in->unsat_core_enabled()) {
+                    (*m_t)(in, result);
+                    return;
+                }
+                std::string path = dir + "/" + goal_key(*in) + ".smt2";
+                if (load(path, *in.get())) {
+                    result.push_back(in.get());
+                    return;
+                }
+                (*m_t)(in, result);
+                if (result.size() == 1)
+                    save(path, *result[0]);
+            }
+
+            void cleanup() override { m_t->cleanup(); }
+            void collect_statistics(statistics & st) const override { m_t->collect_statistics(st); }
+            void reset_statistics() override { m_t->reset_statistics(); }
+            void updt_params(params_ref const & p) override { m_t->updt_params(p); }
+            void collect_param_descrs(param_descrs & r) override { m_t->collect_param_descrs(r); }
+            void reset() override { m_t->reset(); }
+            void set_logic(symbol const & l) override { m_t->set_logic(l); }
+            void set_progress_callback(progress_callback * callback) override { m_t->set_progress_callback(callback); }
+        };
+
+    }
+
+    tactic * mk_preprocess_cache_tactic(ast_manager & m, tactic * t) {
+        return alloc(preprocess_cache_tactic, m, t);
+    }
+
+};
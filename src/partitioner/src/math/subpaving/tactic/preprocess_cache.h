@@ -0,0 +1,52 @@
+/*++
+Module Name:
+
+    preprocess_cache.h
+
+Abstract:
+
+    On-disk cache of the preprocessing of the partitioner.
+
+    Partitioners started on the same input repeat the same
+    preprocessing (purification, term-ite elimination, simplification,
+    CNF conversion) and the same propagation of the root. With
+    partition_cache=<dir>, the preprocessed goal is stored in
+
+        <dir>/<key of the input goal>.smt2
+
+    as an SMT-LIB script whose first line is "; goal <key of the
+    preprocessed goal>", and the bounds of the propagated root in
+
+        <dir>/<key of the preprocessed goal>.root
+
+    (see context_t::load_root_bounds). The key of a goal is a 64-bit
+    hash of its formulas. An entry is only used if the goal parsed
+    from it has the stored key, and it is not written if the goal
+    cannot be printed and parsed back unchanged. Files are written
+    under a temporary name and renamed, so processes can share a
+    cache directory.
+
+Revision History:
+
+--*/
+#pragma once
+
+#include "tactic/tactic.h"
+
+#include <string>
+
+namespace subpaving {
+
+    /**
+       \brief Hash of the formulas of g (and of their order) as 16 hex digits.
+       It does not depend on the process: symbols and numerals are hashed by their text.
+    */
+    std::string goal_key(goal const & g);
+
+    /**
+       \brief Tactic that applies t, or loads the result of t on the same goal from the
+       cache directory given by partition_cache. t must produce a single goal.
+    */
+    tactic * mk_preprocess_cache_tactic(ast_manager & m, tactic * t);
+
+};
@@ -19,18 +19,26 @@ Revision History:
 #include "tactic/tactical.h"
 #include "tactic/core/simplify_tactic.h"
 #include "math/subpaving/tactic/expr2subpaving.h"
+#include "math/subpaving/tactic/task_delta.h"
+#include "math/subpaving/tactic/task_buffer.h"
+#include "math/subpaving/tactic/preprocess_cache.h"
 #include "ast/expr2var.h"
 #include "ast/arith_decl_plugin.h"
 #include "ast/ast_smt2_pp.h"
+#include "ast/decl_collector.h"
 #include "tactic/core/elim_term_ite_tactic.h"
 #include "tactic/core/elim_uncnstr_tactic.h"
 #include "tactic/core/propagate_values_tactic.h"
 #include "tactic/core/solve_eqs_tactic.h"
 #include "tactic/core/tseitin_cnf_tactic.h"
 #include "tactic/arith/purify_arith_tactic.h"
+#include "ast/converters/generic_model_converter.h"
 #include "util/gparams.h"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
 
 class subpaving_tactic : public tactic {
 
@@ -52,6 +60,15 @@ class subpaving_tactic : public tactic {
         }
     };
 
+    /**
+       \brief Declarations already printed in the task base.
+    */
+    struct base_decls : public ast_smt_pp::is_declared {
+        obj_hashtable<func_decl> m_decls;
+        bool operator()(func_decl * d) const override { return m_decls.contains(d); }
+        bool operator()(sort * s) const override { return false; }
+    };
+
     struct imp {
         enum engine_kind { MPQ, MPF, HWF, MPFF, MPFX, NONE };
 
@@ -75,6 +92,25 @@ class subpaving_tactic : public tactic {
         std::string                     m_output_dir;
         unsigned                        m_max_running_tasks;
         bool                            m_get_model_flag;
+        // delta mode: tasks are written against the task base (the first task)
+        bool                            m_delta_tasks;
+        bool                            m_base_written;
+        // a restored partitioner does not overwrite the task base of the previous one
+        bool                            m_restored;
+        std::string                     m_base_name;
+        expr_ref_vector                 m_base_clauses;
+        obj_map<expr, unsigned>         m_base_ids;
+        base_decls                      m_base_decls;
+        // tasks are passed through a shared memory ring buffer when it is available
+        subpaving::task_buffer          m_task_buffer;
+        // directory of the preprocessing cache, see preprocess_cache.h
+        std::string                     m_cache_dir;
+        // tasks share the polynomial definitions, their text and declarations are printed once
+        ast_smt_pp::term_cache          m_print_cache;
+        // partitioning stops after m_max_tasks tasks (0: no limit)
+        unsigned                        m_max_tasks;
+        unsigned                        m_num_printed_tasks;
+        double                          m_print_time;
         unsigned m_int_var_num;
         unsigned m_nl_val_num;
         symbol m_logic;
@@ -87,6 +123,14 @@ class subpaving_tactic : public tactic {
             m_v2e(m),
             m_expr_buffer(m),
             m_task_expr_clauses(m),
+            m_delta_tasks(false),
+            m_base_written(false),
+            m_restored(false),
+            m_base_clauses(m),
+            m_print_cache(m),
+            m_max_tasks(0),
+            m_num_printed_tasks(0),
+            m_print_time(0),
             m_int_var_num(0),
             m_nl_val_num(0),
             m_logic()
@@ -126,6 +170,8 @@ class subpaving_tactic : public tactic {
 
         void collect_statistics(statistics & st) const {
             m_ctx->collect_statistics(st);
+            st.update("printed tasks", m_num_printed_tasks);
+            st.update("task print time", m_print_time);
         }
 
         void reset_statistics() {
@@ -463,23 +509,129 @@ class subpaving_tactic : public tactic {
                 ss << "task-" << m_task.m_node_id;
                 task_name = ss.str();
             }
-            std::ofstream ofs(m_output_dir + "/" + task_name + ".smt2");
+            if (m_delta_tasks) {
+                if (!m_base_written)
+                    display_task_base();
+                display_task_delta(task_name);
+                m_task_expr_clauses.reset();
+                return;
+            }
+            std::string path = m_output_dir + "/" + task_name + ".smt2";
+            bool in_memory = m_task_buffer.is_open();
+            std::ostringstream oss;
+            std::ofstream ofs;
+            if (!in_memory)
+                ofs.open(path);
+            std::ostream & out = in_memory ? static_cast<std::ostream &>(oss) : ofs;
             
             ast_smt_pp pp(m());
             pp.set_benchmark_name(task_name.c_str());
             pp.set_logic(m_logic);
+            pp.set_term_cache(&m_print_cache);
 
             --sz;
             for (unsigned i = 0; i < sz; ++i) {
                 pp.add_assumption(m_task_expr_clauses[i].get());
             }
             
-            pp.display_smt2(ofs, m_task_expr_clauses[sz].get());
+            pp.display_smt2(out, m_task_expr_clauses[sz].get());
             if (m_get_model_flag) {
-                ofs << "(get-model)\n";
+                out << "(get-model)\n";
+            }
+            if (in_memory) {
+                std::string content = oss.str();
+                uint64_t offset;
+                if (m_task_buffer.write(content, offset)) {
+                    m_task.m_buffer_offset = offset;
+                    m_task.m_buffer_length = static_cast<unsigned>(content.size());
+                }
+                else
+                    write_task_file(std::move(path), std::move(content));
             }
             m_task_expr_clauses.reset();
         }
+
+        void write_task_file(std::string && path, std::string && content) {
+            std::ofstream ofs(path);
+            ofs << content;
+        }
+
+        std::string const & task_base_name() {
+            if (m_base_name.empty()) {
+                std::stringstream ss;
+                ss << "task-base";
+                if (m_restored)
+                    ss << "-" << m_task.m_node_id;
+                ss << ".smt2";
+                m_base_name = ss.str();
+            }
+            return m_base_name;
+        }
+
+        // output the current (nonempty) task as the task base, the i-th assertion is clause i.
+        void display_task_base() {
+            std::ostringstream out;
+            ast_smt_pp pp(m());
+            pp.set_benchmark_name("task-base");
+            pp.set_logic(m_logic);
+            pp.set_term_cache(&m_print_cache);
+            unsigned sz = m_task_expr_clauses.size();
+            for (unsigned i = 0; i + 1 < sz; ++i)
+                pp.add_assumption(m_task_expr_clauses.get(i));
+            pp.display_smt2(out, m_task_expr_clauses.get(sz - 1));
+            decl_collector decls(m());
+            for (unsigned i = 0; i < sz; ++i) {
+                expr * e = m_task_expr_clauses.get(i);
+                decls.visit(e);
+                m_base_clauses.push_back(e);
+                m_base_ids.insert_if_not_there(e, i);
+            }
+            for (func_decl * d : decls.get_func_decls())
+                m_base_decls.m_decls.insert(d);
+            write_task_file(m_output_dir + "/" + task_base_name(), out.str());
+            m_base_written = true;
+        }
+
+        // output the current task as a delta of the task base, see task_delta.h
+        void display_task_delta(std::string const & task_name) {
+            std::ostringstream out;
+            bool_vector kept(m_base_clauses.size(), false);
+            ptr_buffer<expr> new_clauses;
+            for (expr * e : m_task_expr_clauses) {
+                unsigned id;
+                if (m_base_ids.find(e, id))
+                    kept[id] = true;
+                else
+                    new_clauses.push_back(e);
+            }
+            out << "; base " << task_base_name() << "\n";
+            out << "; keep";
+            for (unsigned i = 0, sz = kept.size(); i < sz; ++i) {
+                if (!kept[i])
+                    continue;
+                unsigned j = i;
+                while (j + 1 < sz && kept[j + 1])
+                    ++j;
+                out << " " << i;
+                if (j > i)
+                    out << "-" << j;
+                i = j;
+            }
+            out << "\n";
+            ast_smt_pp pp(m());
+            pp.set_benchmark_name(task_name.c_str());
+            pp.set_logic(m_logic);
+            pp.set_term_cache(&m_print_cache);
+            pp.set_is_declared(&m_base_decls);
+            unsigned sz = new_clauses.size();
+            for (unsigned i = 0; i + 1 < sz; ++i)
+                pp.add_assumption(new_clauses[i]);
+            pp.display_smt2(out, sz == 0 ? m().mk_true() : new_clauses[sz - 1]);
+            if (m_get_model_flag) {
+                out << "(get-model)\n";
+            }
+            write_task_file(m_output_dir + "/" + task_name + subpaving::delta_task_extension(), out.str());
+        }
         
         lbool solve() {
             lbool res;
@@ -498,17 +650,57 @@ class subpaving_tactic : public tactic {
                 //   2. all splits have been exhausted.
                 if (res == l_undef)
                     break;
+                // l_true with a model: sat
+                if (m_ctx->found_model())
+                    return l_true;
                 // l_sat: generate task successfully
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
                 display_current_task();
+                m_print_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                m_num_printed_tasks++;
+                if (m_max_tasks != 0 && m_num_printed_tasks >= m_max_tasks)
+                    break;
             }
             return l_undef;
         }
 
+        // a model can be built from the values of the variables if the variables
+        // that are not definitions (sums, products) are constants
+        bool is_model_var(expr * e) const {
+            return is_uninterp_const(e) || m_autil.is_add(e) || m_autil.is_mul(e) || m_autil.is_power(e);
+        }
+
+        model_converter * mk_model_converter() {
+            generic_model_converter * mc = alloc(generic_model_converter, m(), "subpaving");
+            for (unsigned x = 0, sz = m_v2e.size(); x < sz; ++x) {
+                expr * e = m_v2e.get(x);
+                if (e == nullptr || !is_uninterp_const(e))
+                    continue;
+                mpq const & v = m_ctx->model_value(x);
+                if (m().is_bool(e))
+                    mc->add(e, m_qm.is_zero(v) ? m().mk_false() : m().mk_true());
+                else if (m_autil.is_int(e))
+                    mc->add(e, m_autil.mk_int(v));
+                else
+                    mc->add(e, m_autil.mk_real(v));
+            }
+            return mc;
+        }
+
         void get_params() {
             const params_ref &p = gparams::get_ref();
             m_output_dir = p.get_str("output_dir", "ERROR");
             m_max_running_tasks = p.get_uint("partition_max_running_tasks", 32);
+            m_max_tasks = p.get_uint("partition_max_tasks", 0);
             m_get_model_flag = static_cast<bool>(p.get_uint("get_model_flag", 0));
+            m_delta_tasks = p.get_uint("partition_delta_tasks", 0) != 0;
+            m_cache_dir = p.get_str("partition_cache", "");
+            std::string restore_path = p.get_str("partition_restore", "");
+            m_restored = !restore_path.empty();
+            std::string buffer_name = p.get_str("partition_task_buffer", "");
+            // delta tasks refer to the task base by file name, they are always files
+            if (!buffer_name.empty() && !m_delta_tasks && !m_task_buffer.is_open() && !m_task_buffer.open(buffer_name))
+                warning_msg("cannot open the task buffer %s, tasks are written to files", buffer_name.c_str());
         }
 
         void process(goal_ref const & g, 
@@ -549,6 +741,14 @@ class subpaving_tactic : public tactic {
                             tout << "var[" << i << "] = " << mk_smt_pp(m_v2e[i].get(), m_manager) << "\n";
                     }
                 );
+                bool models_enabled = true;
+                for (unsigned i = 0, sz = m_v2e.size(); i < sz && models_enabled; ++i) {
+                    expr * e = m_v2e.get(i);
+                    models_enabled = e == nullptr || is_model_var(e);
+                }
+                m_ctx->set_models_enabled(models_enabled);
+                if (!m_cache_dir.empty())
+                    m_ctx->set_root_cache(m_cache_dir + "/" + subpaving::goal_key(*g) + ".root");
                 m_proc = alloc(display_var_proc, m_e2v);
                 m_ctx->set_display_proc(m_proc.get());
                 m_ctx->set_task_ptr(&m_task);
@@ -577,6 +777,11 @@ class subpaving_tactic : public tactic {
             else if (res == l_false) {
                 g->assert_expr(m().mk_false(), nullptr, nullptr);
             }
+            else if (res == l_true) {
+                // a model was found in the box of a node
+                g->reset();
+                g->add(mk_model_converter());
+            }
             else {
                 UNREACHABLE();
             }
@@ -695,13 +900,14 @@ tactic * mk_subpaving_tactic(ast_manager & m, params_ref const & p) {
     simp2_p.set_bool("arith_lhs", true);
     simp2_p.set_bool("mul_to_power", true);
     return and_then(
-                mk_purify_arith_tactic(m, p),
-                mk_elim_term_ite_tactic(m, p),
-                //#linxi TBD
-                // mk_solve_eqs_tactic(m, p),
-                using_params(mk_simplify_tactic(m, p), simp_p),
-                mk_tseitin_cnf_core_tactic(m, p),
-                using_params(mk_simplify_tactic(m, p), simp2_p),
+                subpaving::mk_preprocess_cache_tactic(m, and_then(
+                    mk_purify_arith_tactic(m, p),
+                    mk_elim_term_ite_tactic(m, p),
+                    //#linxi TBD
+                    // mk_solve_eqs_tactic(m, p),
+                    using_params(mk_simplify_tactic(m, p), simp_p),
+                    mk_tseitin_cnf_core_tactic(m, p),
+                    using_params(mk_simplify_tactic(m, p), simp2_p))),
                 mk_subpaving_tactic_core(m, p)
             );
 }
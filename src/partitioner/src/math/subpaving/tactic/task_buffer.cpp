@@ -0,0 +1,108 @@
+/*++
+Module Name:
+
+    task_buffer.cpp
+
+Abstract:
+
+    Shared memory ring buffer of tasks, see task_buffer.h.
+
+Revision History:
+
+--*/
+#include "math/subpaving/tactic/task_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifndef _WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace subpaving {
+
+    namespace {
+
+        std::atomic<uint64_t> & word(unsigned char * base, unsigned i) {
+            return *reinterpret_cast<std::atomic<uint64_t> *>(base + 8 * i);
+        }
+
+    }
+
+    task_buffer::task_buffer():
+        m_base(nullptr),
+        m_size(0),
+        m_capacity(0),
+        m_wait_ms(1000) {
+    }
+
+    task_buffer::~task_buffer() {
+#ifndef _WINDOWS
+        if (m_base != nullptr)
+            munmap(m_base, m_size);
+#endif
+    }
+
+    bool task_buffer::open(std::string const & name) {
+#ifdef _WINDOWS
+        return false;
+#else
+        if (m_base != nullptr || name.empty())
+            return false;
+        std::string shm_name = name[0] == '/' ? name : "/" + name;
+        int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= header_size) {
+            close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void * base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED)
+            return false;
+        unsigned char * b = static_cast<unsigned char *>(base);
+        uint64_t capacity = word(b, 0).load(std::memory_order_acquire);
+        if (capacity == 0 || capacity > size - header_size) {
+            munmap(base, size);
+            return false;
+        }
+        m_base     = b;
+        m_size     = size;
+        m_capacity = capacity;
+        return true;
+#endif
+    }
+
+    bool task_buffer::write(std::string const & content, uint64_t & offset) {
+        if (m_base == nullptr)
+            return false;
+        uint64_t length = content.size();
+        if (length == 0 || length > m_capacity)
+            return false;
+        uint64_t head = word(m_base, 1).load(std::memory_order_relaxed);
+        uint64_t start = head;
+        uint64_t pos = start % m_capacity;
+        if (pos + length > m_capacity)
+            start += m_capacity - pos;
+        uint64_t end = start + length;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_wait_ms);
+        while (end - word(m_base, 2).load(std::memory_order_acquire) > m_capacity) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        memcpy(m_base + header_size + start % m_capacity, content.data(), length);
+        word(m_base, 1).store(end, std::memory_order_release);
+        offset = start;
+        return true;
+    }
+
+};
@@ -0,0 +1,63 @@
+/*++
+Module Name:
+
+    task_buffer.h
+
+Abstract:
+
+    Ring buffer in POSIX shared memory through which the partitioner
+    passes tasks to the coordinator instead of task files.
+
+    The coordinator creates the shared memory object and the
+    partitioner maps it. Layout (little endian, 64-bit words):
+
+        [0, 8)    capacity of the data area
+        [8, 16)   head, number of bytes written by the partitioner
+        [16, 24)  tail, number of bytes released by the coordinator
+        [64, 64 + capacity)  data area
+
+    Head and tail only grow. A task written at offset o occupies the
+    bytes [o % capacity, o % capacity + length) of the data area; a
+    task never wraps around, the end of the data area is skipped
+    instead. The partitioner announces (offset, length) to the
+    coordinator, which copies the task out and sets the tail to
+    offset + length.
+
+Revision History:
+
+--*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace subpaving {
+
+    class task_buffer {
+        unsigned char * m_base;
+        size_t          m_size;
+        uint64_t        m_capacity;
+        unsigned        m_wait_ms;
+    public:
+        static const size_t header_size = 64;
+
+        task_buffer();
+        ~task_buffer();
+
+        /**
+           \brief Map the shared memory object name.
+           Return false if it does not exist or is malformed.
+        */
+        bool open(std::string const & name);
+        bool is_open() const { return m_base != nullptr; }
+
+        /**
+           \brief Copy content to the buffer and store its offset.
+           Wait a while for the coordinator to release space, and return
+           false if the task does not fit, so it is written to a file instead.
+        */
+        bool write(std::string const & content, uint64_t & offset);
+    };
+
+};
@@ -0,0 +1,244 @@
+/*++
+Module Name:
+
+    task_delta.cpp
+
+Abstract:
+
+    Loader of delta task files, see task_delta.h for the format.
+
+Revision History:
+
+--*/
+#include "math/subpaving/tactic/task_delta.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace subpaving {
+
+    namespace {
+
+        bool read_file(std::string const & path, std::string & content) {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+                return false;
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            content = ss.str();
+            return true;
+        }
+
+        std::string command_name(std::string const & cmd) {
+            unsigned i = 1, sz = static_cast<unsigned>(cmd.size());
+            while (i < sz && isspace(static_cast<unsigned char>(cmd[i])))
+                ++i;
+            unsigned start = i;
+            while (i < sz && !isspace(static_cast<unsigned char>(cmd[i])) && cmd[i] != '(' && cmd[i] != ')')
+                ++i;
+            return cmd.substr(start, i - start);
+        }
+
+        /**
+           \brief Split content into top-level commands, skipping comments.
+        */
+        bool parse_script(std::string const & content, task_script & s) {
+            unsigned depth = 0, start = 0;
+            bool in_symbol = false, in_string = false;
+            for (unsigned i = 0, sz = static_cast<unsigned>(content.size()); i < sz; ++i) {
+                char c = content[i];
+                if (in_symbol) {
+                    in_symbol = c != '|';
+                    continue;
+                }
+                if (in_string) {
+                    // "" is an escaped quote, it is handled as two consecutive strings
+                    in_string = c != '"';
+                    continue;
+                }
+                if (c == '|')
+                    in_symbol = true;
+                else if (c == '"')
+                    in_string = true;
+                else if (c == ';') {
+                    while (i < sz && content[i] != '\n')
+                        ++i;
+                }
+                else if (c == '(') {
+                    if (depth == 0)
+                        start = i;
+                    ++depth;
+                }
+                else if (c == ')') {
+                    if (depth == 0)
+                        return false;
+                    if (--depth == 0) {
+                        std::string cmd = content.substr(start, i + 1 - start);
+                        std::string name = command_name(cmd);
+                        if (name == "assert")
+                            s.m_asserts.push_back(std::move(cmd));
+                        else if (name == "get-model")
+                            s.m_get_model = true;
+                        else if (name != "check-sat" && name != "exit")
+                            s.m_header.push_back(std::move(cmd));
+                    }
+                }
+            }
+            return depth == 0 && !in_symbol && !in_string;
+        }
+
+        /**
+           \brief Return the argument of the header comment "; key arg" of a delta file.
+        */
+        bool get_header_line(std::string const & content, char const * key, std::string & arg) {
+            std::string prefix = std::string("; ") + key;
+            std::istringstream in(content);
+            std::string line;
+            while (std::getline(in, line) && line.compare(0, 1, ";") == 0) {
+                if (line.compare(0, prefix.size(), prefix) != 0)
+                    continue;
+                if (line.size() == prefix.size()) {
+                    arg.clear();
+                    return true;
+                }
+                if (line[prefix.size()] == ' ') {
+                    arg = line.substr(prefix.size() + 1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool is_declaration(std::string const & cmd) {
+            std::string name = command_name(cmd);
+            return name != "set-info" && name != "set-logic" && name != "set-option";
+        }
+
+        bool parse_keep(std::string const & arg, unsigned num_asserts, std::vector<bool> & keep) {
+            keep.assign(num_asserts, false);
+            std::istringstream in(arg);
+            std::string range;
+            while (in >> range) {
+                unsigned lo, hi;
+                char dash;
+                std::istringstream r(range);
+                if (!(r >> lo))
+                    return false;
+                hi = lo;
+                if (r >> dash && (dash != '-' || !(r >> hi)))
+                    return false;
+                if (lo > hi || hi >= num_asserts)
+                    return false;
+                for (unsigned i = lo; i <= hi; ++i)
+                    keep[i] = true;
+            }
+            return true;
+        }
+    }
+
+    bool delta_task_loader::load(std::string const & delta_path, task_script & delta, std::vector<bool> & keep, std::string & err) {
+        std::string delta_content, base_name, keep_arg;
+        if (!read_file(delta_path, delta_content)) {
+            err = "cannot read " + delta_path;
+            return false;
+        }
+        if (!get_header_line(delta_content, "base", base_name) || !get_header_line(delta_content, "keep", keep_arg)) {
+            err = "missing base or keep line in " + delta_path;
+            return false;
+        }
+        std::string::size_type slash = delta_path.find_last_of('/');
+        std::string base_path = slash == std::string::npos ? base_name : delta_path.substr(0, slash + 1) + base_name;
+        if (base_path != m_base_path) {
+            std::string base_content;
+            if (!read_file(base_path, base_content)) {
+                err = "cannot read " + base_path;
+                return false;
+            }
+            m_base = task_script();
+            m_base_path.clear();
+            if (!parse_script(base_content, m_base)) {
+                err = "malformed task base " + base_path;
+                return false;
+            }
+            m_base_path = base_path;
+        }
+        if (!parse_script(delta_content, delta)) {
+            err = "malformed delta task " + delta_path;
+            return false;
+        }
+        if (!parse_keep(keep_arg, static_cast<unsigned>(m_base.m_asserts.size()), keep)) {
+            err = "invalid keep line in " + delta_path;
+            return false;
+        }
+        return true;
+    }
+
+    bool delta_task_loader::materialize(std::string const & delta_path, std::ostream & out, std::string & err) {
+        task_script delta;
+        std::vector<bool> keep;
+        if (!load(delta_path, delta, keep, err))
+            return false;
+        for (std::string const & cmd : m_base.m_header)
+            out << cmd << "\n";
+        // the delta repeats set-info and set-logic, only its declarations are needed
+        for (std::string const & cmd : delta.m_header) {
+            if (is_declaration(cmd))
+                out << cmd << "\n";
+        }
+        for (unsigned i = 0, sz = static_cast<unsigned>(m_base.m_asserts.size()); i < sz; ++i) {
+            if (keep[i])
+                out << m_base.m_asserts[i] << "\n";
+        }
+        for (std::string const & cmd : delta.m_asserts)
+            out << cmd << "\n";
+        out << "(check-sat)\n";
+        if (delta.m_get_model)
+            out << "(get-model)\n";
+        return true;
+    }
+
+    bool delta_task_loader::write_incremental(std::string const & delta_path, std::ostream & out, std::string & err) {
+        task_script delta;
+        std::vector<bool> keep;
+        if (!load(delta_path, delta, keep, err))
+            return false;
+        if (m_asserted_base != m_base_path) {
+            // the backend received the tasks of another base
+            if (!m_asserted_base.empty())
+                out << "(reset)\n";
+            m_declared.clear();
+            // declarations survive pop, they are sent once
+            out << "(set-option :global-declarations true)\n";
+            for (std::string const & cmd : m_base.m_header) {
+                out << cmd << "\n";
+                if (is_declaration(cmd))
+                    m_declared.insert(cmd);
+            }
+            // a task implies the base assertions it does not keep: they are
+            // satisfied by its bounds or replaced by a shorter clause,
+            // so the whole base stays asserted at level 0
+            for (std::string const & cmd : m_base.m_asserts)
+                out << cmd << "\n";
+            m_asserted_base = m_base_path;
+        }
+        for (std::string const & cmd : delta.m_header) {
+            if (is_declaration(cmd) && m_declared.insert(cmd).second)
+                out << cmd << "\n";
+        }
+        out << "(push 1)\n";
+        for (std::string const & cmd : delta.m_asserts)
+            out << cmd << "\n";
+        out << "(check-sat)\n";
+        if (delta.m_get_model)
+            out << "(get-model)\n";
+        out << "(pop 1)\n";
+        return true;
+    }
+
+    bool materialize_delta_task(std::string const & delta_path, std::ostream & out, std::string & err) {
+        delta_task_loader loader;
+        return loader.materialize(delta_path, out, err);
+    }
+
+};
@@ -0,0 +1,84 @@
+/*++
+Module Name:
+
+    task_delta.h
+
+Abstract:
+
+    Delta task files.
+
+    In delta mode the partitioner writes the task of the first
+    converted node once, as a full SMT-LIB file (the task base), and
+    every task as a small delta file against it:
+
+        ; base <file name of the task base>
+        ; keep <ids of the base assertions kept by the task, as i or i-j ranges>
+        <declarations missing in the base>
+        <assertions that are not in the base>
+        (check-sat)
+
+    Assertions of the base are numbered from 0 in the order they
+    appear in the base file.
+
+    A resident worker keeps the task base parsed and turns delta
+    files into incremental scripts for a long-lived backend solver:
+    the base is asserted once, with global declarations, and the
+    assertions of each task are sent between (push 1) and (pop 1).
+
+Revision History:
+
+--*/
+#pragma once
+
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace subpaving {
+
+    /**
+       \brief Extension of delta task files.
+    */
+    inline char const * delta_task_extension() { return ".delta"; }
+
+    /**
+       \brief Top-level commands of an SMT-LIB task file.
+    */
+    struct task_script {
+        std::vector<std::string> m_header;   // commands other than assertions and queries
+        std::vector<std::string> m_asserts;
+        bool                     m_get_model = false;
+    };
+
+    /**
+       \brief Reader of delta task files that parses the task base once.
+    */
+    class delta_task_loader {
+        std::string           m_base_path;
+        task_script           m_base;
+        std::string           m_asserted_base; // task base asserted at level 0 of the backend
+        std::set<std::string> m_declared;      // declarations already sent to the backend
+
+        bool load(std::string const & delta_path, task_script & delta, std::vector<bool> & keep, std::string & err);
+    public:
+        /**
+           \brief Write the full SMT-LIB task described by the delta file delta_path to out.
+        */
+        bool materialize(std::string const & delta_path, std::ostream & out, std::string & err);
+        /**
+           \brief Write the commands that solve the task of delta_path on a backend solver
+           that received the previous incremental tasks, and pop its assertions afterwards.
+           The backend must support :global-declarations and push/pop.
+        */
+        bool write_incremental(std::string const & delta_path, std::ostream & out, std::string & err);
+    };
+
+    /**
+       \brief Write the full SMT-LIB task described by the delta file delta_path to out.
+       The task base is looked up in the directory of delta_path.
+       Return false and store a message in err if a file cannot be read or is malformed.
+    */
+    bool materialize_delta_task(std::string const & delta_path, std::ostream & out, std::string & err);
+
+};
@@ -0,0 +1,139 @@
+/*++
+Module Name:
+
+    tree_journal.cpp
+
+Abstract:
+
+    Journal of the partition tree, see tree_journal.h.
+
+Revision History:
+
+--*/
+#include "math/subpaving/tree_journal.h"
+
+namespace subpaving {
+
+    namespace {
+
+        const uint32_t journal_magic   = 0x4a544150; // "PATJ"
+        const uint32_t journal_version = 1;
+
+        template<typename T>
+        void put(std::ostream & out, T v) {
+            out.write(reinterpret_cast<char const *>(&v), sizeof(T));
+        }
+
+        void put_str(std::ostream & out, std::string const & s) {
+            put<uint32_t>(out, static_cast<uint32_t>(s.size()));
+            out.write(s.data(), s.size());
+        }
+
+        template<typename T>
+        bool get(std::istream & in, T & v) {
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(&v), sizeof(T)));
+        }
+
+        bool get_str(std::istream & in, std::string & s) {
+            uint32_t sz;
+            if (!get(in, sz))
+                return false;
+            s.resize(sz);
+            return sz == 0 || static_cast<bool>(in.read(&s[0], sz));
+        }
+
+        bool get_bool(std::istream & in, bool & b) {
+            unsigned char c;
+            if (!get(in, c))
+                return false;
+            b = c != 0;
+            return true;
+        }
+
+    }
+
+    bool tree_journal::open(std::string const & path, uint64_t fingerprint) {
+        m_out.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_out)
+            return false;
+        put(m_out, journal_magic);
+        put(m_out, journal_version);
+        put(m_out, fingerprint);
+        return true;
+    }
+
+    void tree_journal::write(journal_record const & r) {
+        put<unsigned char>(m_out, r.m_kind);
+        put<uint32_t>(m_out, r.m_node);
+        switch (r.m_kind) {
+        case journal_record::SPLIT:
+            put<uint32_t>(m_out, r.m_left);
+            put<uint32_t>(m_out, r.m_right);
+            put<uint32_t>(m_out, r.m_var);
+            put<unsigned char>(m_out, r.m_lower);
+            put<unsigned char>(m_out, r.m_open);
+            put<uint64_t>(m_out, r.m_draws);
+            put_str(m_out, r.m_text);
+            break;
+        case journal_record::MESSAGE:
+            put_str(m_out, r.m_text);
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool tree_journal::read(std::string const & path, uint64_t fingerprint,
+                            std::vector<journal_record> & records, std::string & err) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            err = "cannot read " + path;
+            return false;
+        }
+        uint32_t magic, version;
+        uint64_t fp;
+        if (!get(in, magic) || !get(in, version) || !get(in, fp) ||
+            magic != journal_magic || version != journal_version) {
+            err = "malformed journal " + path;
+            return false;
+        }
+        if (fp != fingerprint) {
+            err = "journal " + path + " was written for another input";
+            return false;
+        }
+        while (true) {
+            unsigned char k;
+            uint32_t node;
+            if (!get(in, k) || !get(in, node))
+                break;
+            journal_record r(static_cast<journal_record::kind>(k), node);
+            bool ok = true;
+            switch (k) {
+            case journal_record::SPLIT: {
+                uint32_t left, right, x;
+                ok = get(in, left) && get(in, right) && get(in, x) &&
+                     get_bool(in, r.m_lower) && get_bool(in, r.m_open) &&
+                     get(in, r.m_draws) && get_str(in, r.m_text);
+                r.m_left  = left;
+                r.m_right = right;
+                r.m_var   = x;
+                break;
+            }
+            case journal_record::MESSAGE:
+                ok = get_str(in, r.m_text);
+                break;
+            case journal_record::TASK:
+            case journal_record::UNSAT:
+                break;
+            default:
+                err = "malformed journal " + path;
+                return false;
+            }
+            if (!ok)
+                break;
+            records.push_back(std::move(r));
+        }
+        return true;
+    }
+
+};
@@ -0,0 +1,79 @@
+/*++
+Module Name:
+
+    tree_journal.h
+
+Abstract:
+
+    Journal of the partition tree, from which a new partitioner
+    process on the same input rebuilds the tree of a previous one.
+
+    The journal is a binary file (native byte order):
+
+        header:  magic, version, fingerprint of the input (64 bits)
+        records: kind (1 byte) followed by its fields
+
+    SPLIT   parent, left, right, var, lower, open, random draws, split value
+    TASK    node                  the task of the node was announced
+    UNSAT   node                  the partitioner found the node unsat
+    MESSAGE line                  line received from the coordinator
+
+    Strings are stored as a 32-bit length followed by the bytes.
+    The bounds of the nodes are not stored, they are recomputed by
+    propagating the split bounds, so a record is a few dozen bytes.
+    A truncated last record (crash while it was written) is ignored.
+
+Revision History:
+
+--*/
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace subpaving {
+
+struct journal_record {
+    enum kind : unsigned char {
+        SPLIT   = 'S',
+        TASK    = 'T',
+        UNSAT   = 'U',
+        MESSAGE = 'M'
+    };
+    kind        m_kind;
+    unsigned    m_node;     // SPLIT: the parent
+    unsigned    m_left;
+    unsigned    m_right;
+    unsigned    m_var;
+    bool        m_lower;
+    bool        m_open;
+    uint64_t    m_draws;    // numbers drawn from the random generator after the split
+    std::string m_text;     // SPLIT: split value, MESSAGE: line
+
+    journal_record(kind k = TASK, unsigned n = 0):
+        m_kind(k), m_node(n), m_left(0), m_right(0), m_var(0),
+        m_lower(false), m_open(false), m_draws(0) {}
+};
+
+class tree_journal {
+    std::ofstream m_out;
+public:
+    /**
+       \brief Create (or truncate) the journal at path for the input with the given fingerprint.
+    */
+    bool open(std::string const & path, uint64_t fingerprint);
+    bool is_open() const { return m_out.is_open(); }
+    void write(journal_record const & r);
+    void flush() { m_out.flush(); }
+
+    /**
+       \brief Read the records of the journal at path.
+       Return false if it cannot be read or was written for another input.
+    */
+    static bool read(std::string const & path, uint64_t fingerprint,
+                     std::vector<journal_record> & records, std::string & err);
+};
+
+};
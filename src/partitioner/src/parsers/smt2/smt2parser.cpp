@@ -3107,6 +3107,10 @@ namespace smt2 {
             m_scanner.reset_input(is, interactive);
         }
 
+        void reset_input(char const * begin, char const * end) {
+            m_scanner.reset_input(begin, end);
+        }
+
         sexpr_ref parse_sexpr_ref() {
             m_num_bindings    = 0;
             m_num_open_paren = 0;
@@ -3215,6 +3219,13 @@ bool parse_smt2_commands(cmd_context & ctx, std::istream & is, bool interactive,
     return p();
 }
 
+bool parse_smt2_commands(cmd_context & ctx, char const * begin, char const * end, params_ref const & ps, char const * filename) {
+    std::istringstream empty;
+    smt2::parser p(ctx, empty, false, ps, filename);
+    p.reset_input(begin, end);
+    return p();
+}
+
 bool parse_smt2_commands_with_parser(class smt2::parser *& p, cmd_context & ctx, std::istream & is, bool interactive, params_ref const & ps, char const * filename) {
     if (p)
         p->reset_input(is, interactive);
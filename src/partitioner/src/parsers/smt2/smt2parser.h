@@ -27,6 +27,11 @@ namespace smt2 {
 
 bool parse_smt2_commands(cmd_context & ctx, std::istream & is, bool interactive = false, params_ref const & ps = params_ref(), char const * filename = nullptr);
 
+/**
+   \brief Parse the commands in the buffer [begin, end) (nonempty), a memory-mapped file for instance.
+*/
+bool parse_smt2_commands(cmd_context & ctx, char const * begin, char const * end, params_ref const & ps = params_ref(), char const * filename = nullptr);
+
 bool parse_smt2_commands_with_parser(class smt2::parser *& p, cmd_context & ctx, std::istream & is, bool interactive = false, params_ref const & ps = params_ref(), char const * filename = nullptr);
 
 sexpr_ref parse_sexpr(cmd_context& ctx, std::istream& is, params_ref const& ps, char const* filename);
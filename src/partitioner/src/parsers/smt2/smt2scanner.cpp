@@ -18,6 +18,7 @@ Revision History:
 --*/
 #include "parsers/smt2/smt2scanner.h"
 #include "parsers/util/parser_params.hpp"
+#include <cstring>
 
 namespace smt2 {
 
@@ -26,7 +27,13 @@ namespace smt2 {
             m_cache.push_back(m_curr);
         if (m_at_eof)
             throw scanner_exception("unexpected end of file");
-        if (m_interactive) {
+        if (is_mapped()) {
+            if (m_data < m_data_end)
+                m_curr = *m_data++;
+            else
+                m_at_eof = true;
+        }
+        else if (m_interactive) {
             m_curr = m_stream->get();
             if (m_stream->eof())
                 m_at_eof = true;
@@ -50,8 +57,54 @@ namespace smt2 {
         m_spos++;
     }
 
+    // mapped input: the characters from the current one up to p (excluded) are consumed, p becomes the current one
+    void scanner::move_to(char const * p) {
+        SASSERT(!m_at_eof && curr_ptr() <= p && p <= m_data_end);
+        char const * c = curr_ptr();
+        if (m_cache_input)
+            m_cache.append(static_cast<unsigned>(p - c), c);
+        m_spos += static_cast<int>(p - c);
+        if (p < m_data_end) {
+            m_curr = *p;
+            m_data = p + 1;
+        }
+        else {
+            m_data = m_data_end;
+            m_at_eof = true;
+        }
+    }
+
+    void scanner::skip_spaces() {
+        SASSERT(is_mapped() && !m_at_eof);
+        char const * p = curr_ptr();
+        char const * line_begin = nullptr;
+        for (; p < m_data_end; ++p) {
+            char c = *p;
+            if (c == '\n') {
+                m_line++;
+                line_begin = p + 1;
+            }
+            else if (m_normalized[static_cast<unsigned char>(c)] != ' ')
+                break;
+        }
+        move_to(p);
+        if (line_begin != nullptr)
+            m_spos = static_cast<int>(p - line_begin);
+    }
+
     void scanner::read_comment() {
         SASSERT(curr() == ';');
+        if (is_mapped()) {
+            char const * c = curr_ptr();
+            char const * nl = static_cast<char const *>(memchr(c, '\n', m_data_end - c));
+            if (nl == nullptr) {
+                move_to(m_data_end);
+                return;
+            }
+            move_to(nl + 1);
+            new_line();
+            return;
+        }
         next();
         while (true) {
             char c = curr();
@@ -113,6 +166,20 @@ namespace smt2 {
     }
 
     scanner::token scanner::read_symbol_core() {
+        if (is_mapped() && !m_at_eof) {
+            char const * b = curr_ptr();
+            char const * p = b;
+            for (; p < m_data_end; ++p) {
+                signed char n = m_normalized[static_cast<unsigned char>(*p)];
+                if (n != 'a' && n != '0' && n != '-')
+                    break;
+            }
+            m_string.append(static_cast<unsigned>(p - b), b);
+            move_to(p);
+            m_string.push_back(0);
+            m_id = m_string.begin();
+            return SYMBOL_TOKEN;
+        }
         while (!m_at_eof) {
             char c = curr();
             signed char n = m_normalized[static_cast<unsigned char>(c)];
@@ -145,6 +212,42 @@ namespace smt2 {
 
     scanner::token scanner::read_number() {
         SASSERT('0' <= curr() && curr() <= '9');
+        if (is_mapped()) {
+            char const * b = curr_ptr();
+            char const * p = b;
+            bool is_float = false;
+            unsigned num_digits = 0, num_frac_digits = 0;
+            uint64_t val = 0;
+            for (; p < m_data_end; ++p) {
+                char c = *p;
+                if ('0' <= c && c <= '9') {
+                    val = 10 * val + (c - '0');
+                    ++num_digits;
+                    if (is_float)
+                        ++num_frac_digits;
+                }
+                else if (c == '.' && !is_float)
+                    is_float = true;
+                else
+                    break;
+            }
+            if (num_digits <= 18)
+                m_number = rational(val, rational::ui64());
+            else {
+                m_string.reset();
+                for (char const * d = b; d < p; ++d) {
+                    if (*d != '.')
+                        m_string.push_back(*d);
+                }
+                m_string.push_back(0);
+                m_number = rational(m_string.begin());
+            }
+            if (num_frac_digits > 0)
+                m_number /= rational(10).expt(num_frac_digits);
+            move_to(p);
+            TRACE("scanner", tout << "new number: " << m_number << "\n";);
+            return is_float ? FLOAT_TOKEN : INT_TOKEN;
+        }
         rational q(1);
         m_number = rational(curr() - '0');
         next();
@@ -282,6 +385,8 @@ namespace smt2 {
         m_bpos(0),
         m_bend(0),
         m_stream(&stream),
+        m_data(nullptr),
+        m_data_end(nullptr),
         m_cache_input(false) {
 
 
@@ -335,11 +440,14 @@ namespace smt2 {
 
             switch (m_normalized[(unsigned char) c]) {
             case ' ':
-                next();
-                break;
             case '\n':
+                if (is_mapped()) {
+                    skip_spaces();
+                    break;
+                }
                 next();
-                new_line();
+                if (c == '\n')
+                    new_line();
                 break;
             case ';':
                 read_comment();
@@ -390,7 +498,20 @@ namespace smt2 {
         return m_cache_result.begin();
     }
 
+    void scanner::reset_input(char const * begin, char const * end) {
+        m_stream = nullptr;
+        m_data = begin;
+        m_data_end = end;
+        m_interactive = false;
+        m_at_eof = false;
+        m_line = 1;
+        m_spos = 0;
+        next();
+    }
+
     void scanner::reset_input(std::istream & stream, bool interactive) {
+        m_data = nullptr;
+        m_data_end = nullptr;
         m_stream = &stream;
         m_interactive = interactive;
         m_at_eof = false;
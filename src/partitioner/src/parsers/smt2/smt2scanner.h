@@ -50,6 +50,9 @@ namespace smt2 {
         unsigned           m_bend;
         svector<char>      m_string;
         std::istream*      m_stream;
+        // memory-mapped input (m_stream is not used): the character after the current one, and the end
+        char const *       m_data;
+        char const *       m_data_end;
         
         bool               m_cache_input;
         svector<char>      m_cache;
@@ -59,7 +62,12 @@ namespace smt2 {
         char curr() const { return m_curr; }
         void new_line() { m_line++; m_spos = 0; }
         void next();
+        bool is_mapped() const { return m_data != nullptr; }
+        char const * curr_ptr() const { return m_data - 1; }
+        void move_to(char const * p);
+        void skip_spaces();
         
+
     public:
         
         enum token {
@@ -100,6 +108,12 @@ namespace smt2 {
         unsigned cache_size() const { return m_cache.size(); }
         void reset_cache() { m_cache.reset(); }
         void reset_input(std::istream & stream, bool interactive = false);
+        /**
+           \brief Scan the characters in [begin, end), a memory-mapped file for instance.
+           Whitespace, comments, symbols and numerals are consumed in bulk from the buffer,
+           which must stay alive while the scanner is used.
+        */
+        void reset_input(char const * begin, char const * end);
 
         char const * cached_str(unsigned begin, unsigned end);
     };
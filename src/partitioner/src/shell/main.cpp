@@ -33,6 +33,10 @@ Revision History:
 #include "util/gparams.h"
 #include "util/env_params.h"
 #include "util/file_path.h"
+#include "math/subpaving/tactic/task_delta.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 
 #if defined( _WINDOWS ) && defined( __MINGW32__ ) && ( defined( __GNUG__ ) || defined( __clang__ ) )
 #include <crtdbg.h>
@@ -46,7 +50,11 @@ static bool         g_standard_input      = false;
 static input_kind   g_input_kind          = IN_UNSPECIFIED;
 bool                g_display_statistics  = false;
 bool                g_display_model       = false;
+// the model of a sat answer is displayed (-getmodelflag:1), there is none for other answers
+bool                g_display_sat_model   = false;
 static bool         g_display_istatistics = false;
+static char const * g_delta_task_file     = nullptr;
+static char const * g_worker_task_dir     = nullptr;
 
 static void error(const char * msg) {
     std::cerr << "Error: " << msg << "\n";
@@ -81,6 +89,8 @@ void display_usage() {
     std::cout << "  -log        use parser for Z3 log input format.\n";
     std::cout << "  -in         read formula from standard input.\n";
     std::cout << "  -model      display model for satisfiable SMT.\n";
+    std::cout << "  -materialize:file  write the SMT-LIB task of a delta task file (task-<id>.delta) to task-<id>.smt2.\n";
+    std::cout << "  -worker:dir  resident worker, read task ids from standard input and write incremental SMT-LIB for the delta tasks in dir.\n";
     std::cout << "\nMiscellaneous:\n";
     std::cout << "  -h, -?      prints this message.\n";
     std::cout << "  -version    prints version number of Z3.\n";
@@ -305,6 +315,35 @@ static void parse_cmd_line_args(std::string& input_file, int argc, char ** argv)
             }
             else if (strcmp(opt_name, "getmodelflag") == 0) {
                 gparams::set("get_model_flag", opt_arg);
+                g_display_sat_model = opt_arg != nullptr && strcmp(opt_arg, "0") != 0;
+            }
+            else if (strcmp(opt_name, "partidelta") == 0) {
+                gparams::set("partition_delta_tasks", opt_arg);
+            }
+            else if (strcmp(opt_name, "partibuffer") == 0) {
+                gparams::set("partition_task_buffer", opt_arg);
+            }
+            else if (strcmp(opt_name, "partisnapshot") == 0) {
+                gparams::set("partition_snapshot", opt_arg);
+            }
+            else if (strcmp(opt_name, "partirestore") == 0) {
+                gparams::set("partition_restore", opt_arg);
+            }
+            else if (strcmp(opt_name, "partiimport") == 0) {
+                gparams::set("partition_import", opt_arg);
+            }
+            else if (strcmp(opt_name, "particache") == 0) {
+                gparams::set("partition_cache", opt_arg);
+            }
+            else if (strcmp(opt_name, "materialize") == 0) {
+                if (!opt_arg)
+                    error("option argument (-materialize:file) is missing.");
+                g_delta_task_file = opt_arg;
+            }
+            else if (strcmp(opt_name, "worker") == 0) {
+                if (!opt_arg)
+                    error("option argument (-worker:dir) is missing.");
+                g_worker_task_dir = opt_arg;
             }
             else {
                 std::cerr << "Error: invalid command line option: " << arg << "\n";
@@ -336,6 +375,70 @@ static void parse_cmd_line_args(std::string& input_file, int argc, char ** argv)
 }
 
 
+static unsigned materialize_delta_task(char const * delta_file) {
+    std::string delta_path(delta_file);
+    std::string ext = subpaving::delta_task_extension();
+    std::string out_path = delta_path;
+    if (out_path.size() > ext.size() && out_path.compare(out_path.size() - ext.size(), ext.size(), ext) == 0)
+        out_path.resize(out_path.size() - ext.size());
+    out_path += ".smt2";
+    std::ostringstream out;
+    std::string err;
+    if (!subpaving::materialize_delta_task(delta_path, out, err)) {
+        std::cerr << "Error: " << err << "\n";
+        return ERR_OPEN_FILE;
+    }
+    // write to a temporary file first, so a concurrent reader never sees a partial task
+    std::string tmp_path = out_path + ".tmp";
+    {
+        std::ofstream ofs(tmp_path);
+        ofs << out.str();
+        if (!ofs) {
+            std::cerr << "Error: cannot write " << tmp_path << "\n";
+            return ERR_OPEN_FILE;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+        std::cerr << "Error: cannot write " << out_path << "\n";
+        return ERR_OPEN_FILE;
+    }
+    return ERR_OK;
+}
+
+/**
+   \brief Resident worker: the task base is parsed once, and each task id read
+   from the standard input is answered with the incremental script of its
+   delta task, followed by (echo "done <id>"), so that the reader of the
+   backend output can check that the backend is in sync.
+   A task that cannot be loaded is answered with (echo "error <id> <message>").
+*/
+static unsigned run_resident_worker(char const * task_dir) {
+    subpaving::delta_task_loader loader;
+    std::string id;
+    while (std::getline(std::cin, id)) {
+        if (id.empty())
+            continue;
+        if (id == "exit")
+            break;
+        std::string delta_path = std::string(task_dir) + "/task-" + id + subpaving::delta_task_extension();
+        std::ostringstream out;
+        std::string err;
+        if (loader.write_incremental(delta_path, out, err)) {
+            std::cout << out.str() << "(echo \"done " << id << "\")\n";
+        }
+        else {
+            for (char & c : err)
+                if (c == '"')
+                    c = '\'';
+            std::cout << "(echo \"error " << id << " " << err << "\")\n";
+        }
+        std::cout.flush();
+    }
+    std::cout << "(exit)\n";
+    std::cout.flush();
+    return ERR_OK;
+}
+
 int STD_CALL main(int argc, char ** argv) {
      try {
         unsigned return_value = 0;
@@ -345,6 +448,12 @@ int STD_CALL main(int argc, char ** argv) {
         parse_cmd_line_args(input_file, argc, argv);
         env_params::updt_params();
 
+        if (g_delta_task_file) {
+            return materialize_delta_task(g_delta_task_file);
+        }
+        if (g_worker_task_dir) {
+            return run_resident_worker(g_worker_task_dir);
+        }
         if (g_input_file && g_standard_input) {
             error("using standard input to read formula.");
         }
@@ -21,6 +21,10 @@ Revision History:
 #include<iostream>
 #include<time.h>
 #include<signal.h>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
 #include "util/timeout.h"
 #include "util/mutex.h"
 #include "parsers/smt2/smt2parser.h"
@@ -33,6 +37,7 @@ static mutex *display_stats_mux = new mutex;
 
 extern bool g_display_statistics;
 extern bool g_display_model;
+extern bool g_display_sat_model;
 static clock_t             g_start_time;
 static cmd_context *       g_cmd_context = nullptr;
 
@@ -50,7 +55,8 @@ static void display_statistics() {
 }
 
 static void display_model() {
-    if (g_display_model && g_cmd_context) {
+    if (g_cmd_context && (g_display_model ||
+                          (g_display_sat_model && g_cmd_context->cs_state() == cmd_context::css_sat))) {
         model_ref mdl;
         if (g_cmd_context->is_model_available(mdl))
             g_cmd_context->display_model(mdl);
@@ -115,6 +121,26 @@ void help_probes() {
         std::cout << "- " << cmd->get_name() << " " << cmd->get_descr() << "\n";
 }
 
+// map a nonempty regular file into memory, read-only
+static bool map_file(char const * file_name, char const * & data, size_t & size) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    void * p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    madvise(p, size, MADV_SEQUENTIAL);
+    data = static_cast<char const *>(p);
+    return true;
+}
+
 unsigned read_smtlib2_commands(char const * file_name) {
     g_start_time = clock();
     register_on_timeout_proc(on_timeout);
@@ -127,7 +153,14 @@ unsigned read_smtlib2_commands(char const * file_name) {
     signal(SIGINT, on_ctrl_c);
 
     bool result = true;
-    if (file_name) {
+    char const * data = nullptr;
+    size_t size = 0;
+    if (file_name && map_file(file_name, data, size)) {
+        // the scanner reads the mapped file directly, large inputs are not copied through a stream
+        result = parse_smt2_commands(ctx, data, data + size);
+        munmap(const_cast<char *>(data), size);
+    }
+    else if (file_name) {
         std::ifstream in(file_name);
         if (in.bad() || in.fail()) {
             std::cerr << "(error \"failed to open file '" << file_name << "'\")" << std::endl;
@@ -46,4 +46,25 @@ void env_params::collect_param_descrs(param_descrs & d) {
     d.insert("partition_max_running_tasks", CPK_UINT, "AriParti maximum number of tasks running simultaneously", "32");
     d.insert("partition_rand_seed", CPK_UINT, "AriParti random seed", "0");
     d.insert("get_model_flag", CPK_UINT, "AriParti get model flag", "0");
+    d.insert("partition_root_prop_ms", CPK_UINT, "AriParti propagation time budget (in milliseconds) at the root", "10000");
+    d.insert("partition_prop_ms", CPK_UINT, "AriParti propagation time budget (in milliseconds) at other nodes", "5000");
+    d.insert("partition_prop_work", CPK_UINT, "AriParti maximum number of propagation work units per node, if 0 then there is no limit", "0");
+    d.insert("partition_lookahead", CPK_UINT, "AriParti number of split candidates compared by tentatively splitting them, if 0 then lookahead is disabled", "0");
+    d.insert("partition_lookahead_ms", CPK_UINT, "AriParti time budget (in milliseconds) of a lookahead", "1000");
+    d.insert("partition_lp_refute", CPK_UINT, "AriParti check the linear relaxation of every node (polynomial definitions, McCormick inequalities of bilinear and square monomials, bounds) and report the infeasible ones as unsat without writing their tasks", "0");
+    d.insert("partition_lp_pivots", CPK_UINT, "AriParti maximum number of simplex pivots of a check of the linear relaxation", "500");
+    d.insert("partition_sat_samples", CPK_UINT, "AriParti number of points of the box of a node evaluated by a local search for a model before its task is written, a model found is reported as sat; tasks without clauses are searched with at least 16 points", "0");
+    d.insert("partition_fp_filter", CPK_UINT, "AriParti skip the polynomial and monomial propagations that cannot improve a bound, as shown by double precision intervals with outward rounding; new bounds are always computed with rationals", "0");
+    d.insert("partition_lemmas", CPK_UINT, "AriParti learn lemmas from inconsistent nodes to prune other subtrees", "1");
+    d.insert("partition_export_lemmas", CPK_UINT, "AriParti add the learned lemmas to the task files", "0");
+    d.insert("partition_cost_model", CPK_UINT, "AriParti order of the leaves to be split: 0 - depth and task size, 1 - linear cost model trained with the solving times reported by the coordinator", "0");
+    d.insert("partition_gc", CPK_UINT, "AriParti free the nodes of solved and terminated subtrees", "1");
+    d.insert("partition_delta_tasks", CPK_UINT, "AriParti write the first task once (task-base.smt2) and every task as a delta against it (task-<id>.delta)", "0");
+    d.insert("partition_task_buffer", CPK_STRING, "AriParti name of the shared memory ring buffer created by the coordinator to pass the tasks through, if empty then tasks are written to files", "");
+    d.insert("partition_snapshot", CPK_STRING, "AriParti path of the journal of the partition tree, from which a restarted partitioner rebuilds the tree (partition_restore), if empty then no journal is written", "");
+    d.insert("partition_restore", CPK_STRING, "AriParti path of a journal of the partition tree written by a previous partitioner on the same input, the tree is rebuilt from it before partitioning goes on", "");
+    d.insert("partition_import", CPK_STRING, "AriParti path of a subtree exported by another partitioner for the node whose task is the input, its splits are reused and its unsat nodes are not solved again", "");
+    d.insert("partition_cache", CPK_STRING, "AriParti directory of a cache of the preprocessed goals and of their root bounds shared by partitioners on the same input, if empty then nothing is cached", "");
+    d.insert("partition_debug", CPK_UINT, "AriParti write debug information to partitioner-debug.txt in the output dir", "0");
+    d.insert("partition_max_tasks", CPK_UINT, "AriParti stop partitioning after this many tasks were written (used by partitioner-bench), if 0 then there is no limit", "0");
 }
@@ -0,0 +1,128 @@
+import os
+import fcntl
+import select
+import logging
+import subprocess
+from enum import Enum, auto
+
+class ResidentSolverStatus(Enum):
+    idle = auto()
+    solving = auto()
+    stopped = auto()
+
+    def is_idle(self):
+        return self == ResidentSolverStatus.idle
+
+    def is_solving(self):
+        return self == ResidentSolverStatus.solving
+
+    def is_stopped(self):
+        return self == ResidentSolverStatus.stopped
+
+# a long-lived backend solver fed by a resident worker:
+# the worker (partitioner -worker:dir) keeps the task base parsed and
+# turns each task id into an incremental script, which is piped into the backend.
+# every task ends with (echo "done <id>"), the echo checks that the backend is in sync.
+class ResidentSolver:
+    def __init__(self, worker_cmd: list, backend_cmd: list):
+        self.worker_cmd = worker_cmd
+        self.backend_cmd = backend_cmd
+        self.worker: subprocess.Popen = None
+        self.backend: subprocess.Popen = None
+        self.status = ResidentSolverStatus.stopped
+        self.task_id = None
+        self.partial_line = ''
+        self.lines = []
+
+    def is_idle(self):
+        return not self.status.is_solving()
+
+    def start(self):
+        self.worker = subprocess.Popen(
+                self.worker_cmd,
+                stdin=subprocess.PIPE,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.DEVNULL,
+                text=True
+            )
+        self.backend = subprocess.Popen(
+                self.backend_cmd,
+                stdin=self.worker.stdout,
+                stdout=subprocess.PIPE,
+                stderr=subprocess.DEVNULL,
+                text=True
+            )
+        # the backend owns the read end of the pipe
+        self.worker.stdout.close()
+        flags = fcntl.fcntl(self.backend.stdout, fcntl.F_GETFL)
+        fcntl.fcntl(self.backend.stdout, fcntl.F_SETFL, flags | os.O_NONBLOCK)
+        self.partial_line = ''
+        self.status = ResidentSolverStatus.idle
+
+    def stop(self):
+        if self.status.is_stopped():
+            return
+        for p in (self.worker, self.backend):
+            if p.poll() is None:
+                p.kill()
+            p.wait()
+        self.worker = None
+        self.backend = None
+        self.status = ResidentSolverStatus.stopped
+
+    # same interface as the Popen of a solving process
+    def terminate(self):
+        # the backend cannot be interrupted reliably, it is restarted on the next task
+        if self.status.is_solving():
+            self.stop()
+
+    def solve(self, task_id: str):
+        assert(self.is_idle())
+        if self.status.is_stopped():
+            self.start()
+        self.task_id = task_id
+        self.lines = []
+        self.status = ResidentSolverStatus.solving
+        try:
+            self.worker.stdin.write(task_id + '\n')
+            self.worker.stdin.flush()
+        except (BrokenPipeError, OSError):
+            # reported as an error by receive_result
+            pass
+
+    # None while solving, otherwise (True, output) for a finished task
+    # and (False, message) if the task failed or the backend is out of sync
+    def receive_result(self):
+        assert(self.status.is_solving())
+        ready, _, _ = select.select([self.backend.stdout], [], [], 0)
+        if not ready:
+            return None
+        data = self.backend.stdout.read()
+        if data is None:
+            return None
+        if data == '':
+            return self.fail(f'backend exited with return code {self.backend.poll()}')
+        data = self.partial_line + data
+        lines = data.split('\n')
+        self.partial_line = lines.pop()
+        for raw_line in lines:
+            line = raw_line.strip()
+            if line.startswith('(error'):
+                return self.fail(line)
+            marker = line.strip('"').split(' ', 2)
+            if len(marker) >= 2 and marker[0] in ('done', 'error'):
+                if marker[1] != self.task_id:
+                    return self.fail(f'backend out of sync, expected task {self.task_id}, got {line}')
+                if marker[0] == 'error':
+                    return self.fail(line)
+                self.status = ResidentSolverStatus.idle
+                if self.partial_line != '':
+                    return self.fail(f'unexpected output after task {self.task_id}')
+                return (True, '\n'.join(self.lines))
+            self.lines.append(raw_line)
+        return None
+
+    def fail(self, msg: str):
+        logging.error(f'resident solver error on task {self.task_id}: {msg}')
+        self.stop()
+        return (False, msg)
@@ -0,0 +1,58 @@
+import os
+import struct
+import logging
+from multiprocessing import shared_memory
+
+# shared memory ring buffer through which the partitioner passes the tasks,
+# see task_buffer.h in the partitioner for the layout.
+# each announced task is copied to a memfd, which a solver opens as /proc/self/fd/<fd>,
+# and its space is released to the partitioner right away.
+class TaskBuffer:
+    header_size = 64
+
+    def __init__(self, name: str, capacity: int):
+        self.shm = shared_memory.SharedMemory(name=name, create=True,
+                                              size=self.header_size + capacity)
+        self.name = self.shm.name
+        self.capacity = capacity
+        struct.pack_into('<QQQ', self.shm.buf, 0, capacity, 0, 0)
+        # task tag -> memfd
+        self.task_fds = {}
+
+    def receive_task(self, task_tag: str, offset: int, length: int):
+        pos = self.header_size + offset % self.capacity
+        fd = os.memfd_create(f'task-{task_tag}')
+        data = self.shm.buf[pos: pos + length]
+        while len(data) > 0:
+            data = data[os.write(fd, data): ]
+        # release the space of the task (and of the skipped end of the data area)
+        struct.pack_into('<Q', self.shm.buf, 16, offset + length)
+        self.task_fds[task_tag] = fd
+
+    def get_task_path(self, task_tag: str):
+        fd = self.task_fds.get(task_tag)
+        if fd == None:
+            return None
+        return f'/proc/self/fd/{fd}'
+
+    # the file descriptors a solver of the task must inherit
+    def get_task_fds(self, task_tag: str):
+        fd = self.task_fds.get(task_tag)
+        if fd == None:
+            return ()
+        return (fd, )
+
+    def release_task(self, task_tag: str):
+        fd = self.task_fds.pop(task_tag, None)
+        if fd != None:
+            os.close(fd)
+
+    def close(self):
+        for fd in self.task_fds.values():
+            os.close(fd)
+        self.task_fds = {}
+        self.shm.close()
+        try:
+            self.shm.unlink()
+        except FileNotFoundError:
+            logging.debug(f'task buffer {self.name} was already unlinked')
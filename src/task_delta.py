@@ -0,0 +1,165 @@
+import os
+import re
+
+# delta task files, see task_delta.h in the partitioner for the format:
+#   ; base <file name of the task base>
+#   ; keep <ids of the base assertions kept by the task, as i or i-j ranges>
+#   <declarations missing in the base>
+#   <assertions that are not in the base>
+#   (check-sat)
+# the SMT-LIB task is spliced from the base and the delta in-process,
+# with the same output as the partitioner's -materialize option.
+
+class DeltaTaskError(Exception):
+    pass
+
+class TaskScript:
+    def __init__(self):
+        # commands other than assertions and queries
+        self.header = []
+        self.asserts = []
+        self.get_model = False
+
+def command_name(cmd: str):
+    i = 1
+    while i < len(cmd) and cmd[i].isspace():
+        i += 1
+    start = i
+    while i < len(cmd) and not cmd[i].isspace() and cmd[i] not in '()':
+        i += 1
+    return cmd[start: i]
+
+# characters that change the nesting or the lexical state of the script
+special_chars = re.compile(r'[|";()]')
+
+# split content into top-level commands, skipping comments
+def parse_script(content: str):
+    s = TaskScript()
+    depth = 0
+    start = 0
+    i = 0
+    while True:
+        m = special_chars.search(content, i)
+        if m == None:
+            break
+        i = m.start()
+        c = content[i]
+        if c == '|' or c == '"':
+            # "" is an escaped quote, it is handled as two consecutive strings
+            i = content.find(c, i + 1)
+            if i == -1:
+                return None
+        elif c == ';':
+            i = content.find('\n', i)
+            if i == -1:
+                break
+        elif c == '(':
+            if depth == 0:
+                start = i
+            depth += 1
+        else:
+            if depth == 0:
+                return None
+            depth -= 1
+            if depth == 0:
+                cmd = content[start: i + 1]
+                name = command_name(cmd)
+                if name == 'assert':
+                    s.asserts.append(cmd)
+                elif name == 'get-model':
+                    s.get_model = True
+                elif name != 'check-sat' and name != 'exit':
+                    s.header.append(cmd)
+        i += 1
+    if depth != 0:
+        return None
+    return s
+
+# the argument of the header comment "; key arg" of a delta file
+def get_header_line(content: str, key: str):
+    prefix = f'; {key}'
+    for line in content.split('\n'):
+        if not line.startswith(';'):
+            break
+        if not line.startswith(prefix):
+            continue
+        if len(line) == len(prefix):
+            return ''
+        if line[len(prefix)] == ' ':
+            return line[len(prefix) + 1: ]
+    return None
+
+def is_declaration(cmd: str):
+    return command_name(cmd) not in ['set-info', 'set-logic', 'set-option']
+
+def parse_keep(arg: str, num_asserts: int):
+    keep = [False] * num_asserts
+    for r in arg.split():
+        lo, dash, hi = r.partition('-')
+        if not lo.isdigit() or (dash != '' and not hi.isdigit()):
+            return None
+        lo = int(lo)
+        hi = int(hi) if dash != '' else lo
+        if lo > hi or hi >= num_asserts:
+            return None
+        for i in range(lo, hi + 1):
+            keep[i] = True
+    return keep
+
+# task files are read and written as latin-1, which keeps their bytes unchanged
+def read_file(path: str):
+    with open(path, 'r', encoding='latin-1', newline='') as file:
+        return file.read()
+
+# reader of delta task files that parses the task base once
+class DeltaTaskLoader:
+    def __init__(self):
+        # path (or name) of the parsed task base
+        self.base_path = None
+        self.base = None
+
+    def set_base(self, base_path: str, base_content: str):
+        base = parse_script(base_content)
+        if base == None:
+            raise DeltaTaskError(f'malformed task base {base_path}')
+        self.base_path = base_path
+        self.base = base
+
+    # file name of the task base of a delta
+    @staticmethod
+    def get_base_name(delta_content: str):
+        base_name = get_header_line(delta_content, 'base')
+        if base_name == None:
+            raise DeltaTaskError('missing base line in delta task')
+        return base_name
+
+    # the full SMT-LIB task of a delta of the current task base
+    def splice(self, delta_content: str):
+        keep_arg = get_header_line(delta_content, 'keep')
+        if keep_arg == None:
+            raise DeltaTaskError('missing keep line in delta task')
+        delta = parse_script(delta_content)
+        if delta == None:
+            raise DeltaTaskError('malformed delta task')
+        keep = parse_keep(keep_arg, len(self.base.asserts))
+        if keep == None:
+            raise DeltaTaskError('invalid keep line in delta task')
+        out = []
+        out.extend(self.base.header)
+        # the delta repeats set-info and set-logic, only its declarations are needed
+        out.extend(cmd for cmd in delta.header if is_declaration(cmd))
+        out.extend(cmd for i, cmd in enumerate(self.base.asserts) if keep[i])
+        out.extend(delta.asserts)
+        out.append('(check-sat)')
+        if delta.get_model:
+            out.append('(get-model)')
+        return '\n'.join(out) + '\n'
+
+    # the full SMT-LIB task of the delta file delta_path,
+    # the task base is looked up in the directory of delta_path
+    def materialize(self, delta_path: str):
+        delta_content = read_file(delta_path)
+        base_path = os.path.join(os.path.dirname(delta_path), self.get_base_name(delta_content))
+        if base_path != self.base_path:
+            self.set_base(base_path, read_file(base_path))
+        return self.splice(delta_content)
@@ -0,0 +1,11 @@
+(set-info :status sat)
+(set-logic QF_NRA)
+(declare-fun x () Real)
+(declare-fun y () Real)
+(assert (> x 0.0))
+(assert (> y 0.0))
+(assert (> (* x y) 2.0))
+(assert (< (* x y) 3.0))
+(assert (< (+ x y) 4.0))
+(check-sat)
+(exit)
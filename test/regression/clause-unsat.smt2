@@ -0,0 +1,9 @@
+(set-info :status unsat)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(assert (and (>= x 3) (<= x 4) (>= y 0) (>= z 0)))
+(assert (or (>= x 6) (<= (+ y z) (- 1)) (<= x 1)))
+(check-sat)
+(exit)
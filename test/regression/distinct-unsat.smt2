@@ -0,0 +1,15 @@
+(set-info :status unsat)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(declare-fun w () Int)
+(assert (and (>= x 0) (<= x 2) (>= y 0) (<= y 2) (>= z 0) (<= z 2) (>= w 0) (<= w 2)))
+(assert (or (< x y) (> x y)))
+(assert (or (< x z) (> x z)))
+(assert (or (< x w) (> x w)))
+(assert (or (< y z) (> y z)))
+(assert (or (< y w) (> y w)))
+(assert (or (< z w) (> z w)))
+(check-sat)
+(exit)
@@ -0,0 +1,12 @@
+(set-info :status sat)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(assert (and (>= x 0) (<= x 100) (>= y 0) (<= y 100) (>= z 0) (<= z 100)))
+(assert (or (>= x 60) (>= (+ y z) 150)))
+(assert (or (>= x 50) (>= (+ y z) 140) (>= z 90)))
+(assert (or (<= x 10) (>= (* 2 y) 120)))
+(assert (or (<= x 20) (>= (* 2 y) 110)))
+(check-sat)
+(exit)
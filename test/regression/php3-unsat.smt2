@@ -0,0 +1,11 @@
+(set-info :status unsat)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun y () Int)
+(declare-fun z () Int)
+(assert (and (>= x 0) (<= x 1) (>= y 0) (<= y 1) (>= z 0) (<= z 1)))
+(assert (or (< x y) (> x y)))
+(assert (or (< x z) (> x z)))
+(assert (or (< y z) (> y z)))
+(check-sat)
+(exit)
@@ -0,0 +1,8 @@
+(set-info :status unsat)
+(set-logic QF_NRA)
+(declare-fun x () Real)
+(declare-fun y () Real)
+(assert (< (+ (* x x) (* y y)) 1.0))
+(assert (> (* x y) 1.0))
+(check-sat)
+(exit)
@@ -0,0 +1,216 @@
+#!/bin/bash
+# Regression tests of the partitioner, and unit tests of the python modules.
+#
+# Every partitioner test partitions instances of test/regression without a
+# coordinator and checks the answer of the partitioner: sat or unsat if it
+# decided the instance itself, unknown if partitioning stopped with tasks left
+# to the base solvers (after partition_max_tasks tasks at most). Tests may
+# also check the debug output (partitioner-debug.txt) and the task files.
+#
+# usage: test/run_tests.sh [partitioner binary]
+#   the default binary is src/partitioner/build/z3
+
+TEST_DIR=$(cd "$(dirname "$0")" && pwd)
+PARTITIONER=${1:-$TEST_DIR/../src/partitioner/build/z3}
+MAX_TASKS=16
+TIMEOUT=60
+
+if [ ! -x "$PARTITIONER" ]; then
+    echo "partitioner binary $PARTITIONER not found, build it first"
+    exit 1
+fi
+
+# the outputs of the tests are kept if a test fails
+OUTPUT_DIR=$(mktemp -d /tmp/partitioner-tests-XXXXXX)
+
+# message of the failed check of the current test
+fail_msg=""
+
+fail() {
+    fail_msg=$1
+    return 1
+}
+
+# run_case <name> <instance> <expected answer> [param=value ...]
+# partition test/regression/<instance>, its output dir is $case_dir
+run_case() {
+    local name=$1 instance=$TEST_DIR/regression/$2 expected=$3
+    shift 3
+    case_dir=$OUTPUT_DIR/$name
+    mkdir -p "$case_dir"
+    local answer
+    answer=$(timeout $TIMEOUT "$PARTITIONER" "$instance" -outputdir:"$case_dir" \
+                 partition_max_tasks=$MAX_TASKS partition_debug=1 "$@" < /dev/null \
+             | grep -E '^(sat|unsat|unknown)$' | tail -n 1)
+    [ "$answer" == "$expected" ] || fail "$name: expected $expected, got ${answer:-no answer}"
+}
+
+# the debug output of the last case has a line matching the pattern
+expect_debug() {
+    grep -q -E "$1" "$case_dir/partitioner-debug.txt" || fail "$(basename "$case_dir"): no debug line matching '$1'"
+}
+
+# the debug output of the last case has no line matching the pattern
+expect_no_debug() {
+    ! grep -q -E "$1" "$case_dir/partitioner-debug.txt" || fail "$(basename "$case_dir"): unexpected debug line matching '$1'"
+}
+
+# the last case wrote n task files
+expect_tasks() {
+    local n
+    n=$(ls "$case_dir" | grep -c '^task-[0-9]*\.smt2$')
+    [ "$n" == "$1" ] || fail "$(basename "$case_dir"): expected $1 tasks, got $n"
+}
+
+# the task files of the last case are identical to the ones of the same name in dir
+expect_same_tasks() {
+    local task
+    for task in "$case_dir"/task-*; do
+        cmp -s "$task" "$1/$(basename "$task")" || { fail "$(basename "$case_dir"): $(basename "$task") differs"; return 1; }
+    done
+}
+
+# the delta tasks of the last case are the tasks of the same name in dir: materialized by
+# the partitioner and spliced by the coordinator (task_delta.py), they are the same files,
+# with the commands of the task in dir (in another order)
+expect_same_delta_tasks() {
+    local delta msg
+    for delta in "$case_dir"/task-*.delta; do
+        "$PARTITIONER" -materialize:"$delta" > /dev/null || { fail "cannot materialize $(basename "$delta")"; return 1; }
+    done
+    msg=$(python3 - "$case_dir" "$1" "$TEST_DIR/../src" 2>&1 <<'EOF'
+import glob
+import os
+import sys
+sys.path.insert(0, sys.argv[3])
+from task_delta import DeltaTaskLoader, parse_script, read_file
+
+delta_dir, full_dir = sys.argv[1], sys.argv[2]
+names = sorted(os.path.basename(path)[: -len('.delta')] for path in glob.glob(os.path.join(delta_dir, 'task-*.delta')))
+full_names = sorted(os.path.basename(path)[: -len('.smt2')] for path in glob.glob(os.path.join(full_dir, 'task-*.smt2')))
+if names != full_names:
+    sys.exit(f'delta tasks {names}, full tasks {full_names}')
+loader = DeltaTaskLoader()
+for name in names:
+    spliced = loader.materialize(os.path.join(delta_dir, name + '.delta'))
+    if spliced != read_file(os.path.join(delta_dir, name + '.smt2')):
+        sys.exit(f'{name} spliced by task_delta.py differs')
+    full = parse_script(read_file(os.path.join(full_dir, name + '.smt2')))
+    task = parse_script(spliced)
+    if sorted(task.header) != sorted(full.header) or sorted(task.asserts) != sorted(full.asserts):
+        sys.exit(f'{name} has other commands than the full task')
+EOF
+    ) || fail "$(basename "$case_dir"): $msg"
+}
+
+# the resident worker answers the delta tasks of dir with one script: the task
+# base is asserted once, then every task is checked between push and pop
+expect_worker_script() {
+    local ids n script
+    ids=$(ls "$1" | sed -n 's/^task-\([0-9]*\)\.delta$/\1/p')
+    n=$(echo "$ids" | wc -l)
+    script=$(echo "$ids" | "$PARTITIONER" -worker:"$1")
+    [ "$(grep -c '^(set-option :global-declarations true)$' <<< "$script")" == 1 ] &&
+    [ "$(grep -c '^(push 1)$' <<< "$script")" == "$n" ] &&
+    [ "$(grep -c '^(pop 1)$' <<< "$script")" == "$n" ] &&
+    [ "$(grep -c '^(echo "done [0-9]*")$' <<< "$script")" == "$n" ] ||
+        fail "$(basename "$1"): unexpected resident worker script"
+}
+
+# clause propagation with watched literals
+test_watched_literals() {
+    # the clause is falsified by the root bounds
+    run_case clause-unsat clause-unsat.smt2 unsat &&
+    run_case clause-unsat-budget clause-unsat.smt2 unsat partition_prop_work=1 &&
+    run_case distinct distinct-unsat.smt2 unknown &&
+    # nodes run out of propagation budget, their watches are revisited in their children
+    run_case distinct-budget distinct-unsat.smt2 unknown partition_prop_work=1 &&
+    expect_tasks $MAX_TASKS
+}
+
+# removal of the clauses dominated by other clauses
+test_dominated_clauses() {
+    # two of the four clauses are implied by the other two
+    run_case dominated dominated.smt2 sat &&
+    expect_debug 'remove_dominated_clauses before: 4, after: 2'
+}
+
+# lemmas learned from inconsistent nodes
+test_lemmas() {
+    # both children of the root are inconsistent, the root task is left to the base solvers
+    run_case lemmas php3-unsat.smt2 unknown &&
+    expect_debug 'lemma of size [0-9]+ learned at node-' &&
+    run_case no-lemmas php3-unsat.smt2 unknown partition_lemmas=0 &&
+    expect_no_debug 'lemma of size'
+}
+
+# collection of the nodes of solved subtrees
+test_node_gc() {
+    run_case gc php3-unsat.smt2 unknown &&
+    expect_debug 'collected nodes: [1-9][0-9]*, live nodes: ' &&
+    run_case gc-distinct distinct-unsat.smt2 unknown &&
+    expect_debug 'collected nodes: [1-9][0-9]*, live nodes: ' &&
+    run_case no-gc distinct-unsat.smt2 unknown partition_gc=0 &&
+    expect_no_debug 'collected nodes'
+}
+
+# journal of the partition tree, restored by a restarted partitioner
+test_tree_journal() {
+    local journal=$OUTPUT_DIR/distinct.journal
+    run_case journal distinct-unsat.smt2 unknown partition_max_tasks=4 partition_snapshot="$journal" &&
+    expect_tasks 4 &&
+    run_case fresh distinct-unsat.smt2 unknown &&
+    # the restored partitioner writes the tasks of the alive nodes again, then goes on
+    run_case restored distinct-unsat.smt2 unknown partition_restore="$journal" &&
+    expect_debug 'replayed journal records: ([0-9]+)/\1,' &&
+    expect_same_tasks "$OUTPUT_DIR/fresh" &&
+    # the journal is ignored for another input
+    run_case restored-other php3-unsat.smt2 unknown partition_restore="$journal" &&
+    expect_debug 'the tree is not restored: journal .* was written for another input'
+}
+
+# search of a model in the box of a node
+test_box_model_search() {
+    run_case box-sat box-sat.smt2 sat partition_sat_samples=64 &&
+    expect_debug 'node-[0-9]+ model found in its box' &&
+    # no model is reported for unsat instances
+    run_case box-square square-unsat.smt2 unsat partition_sat_samples=64 &&
+    run_case box-clauses php3-unsat.smt2 unknown partition_sat_samples=64 &&
+    expect_no_debug 'model found'
+}
+
+# tasks written as deltas against a task base
+test_delta_tasks() {
+    run_case full distinct-unsat.smt2 unknown &&
+    run_case delta distinct-unsat.smt2 unknown partition_delta_tasks=1 &&
+    expect_same_delta_tasks "$OUTPUT_DIR/full" &&
+    expect_worker_script "$OUTPUT_DIR/delta" &&
+    run_case delta-unsat clause-unsat.smt2 unsat partition_delta_tasks=1 &&
+    run_case delta-sat box-sat.smt2 sat partition_delta_tasks=1
+}
+
+# unit tests of the python modules of the coordinator, in test/unit
+test_python_modules() {
+    local msg
+    msg=$(python3 -m unittest discover -s "$TEST_DIR/unit" 2>&1) || fail "$msg"
+}
+
+num_passed=0
+num_failed=0
+for test in $(declare -F | awk '$3 ~ /^test_/ { print $3 }'); do
+    fail_msg=""
+    if $test; then
+        echo "ok      ${test#test_}"
+        num_passed=$((num_passed + 1))
+    else
+        echo "FAILED  ${test#test_}: $fail_msg"
+        num_failed=$((num_failed + 1))
+    fi
+done
+
+echo "$num_passed passed, $num_failed failed"
+if [ $num_failed != 0 ]; then
+    echo "outputs of the tests: $OUTPUT_DIR"
+    exit 1
+fi
+rm -rf "$OUTPUT_DIR"
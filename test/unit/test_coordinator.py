@@ -0,0 +1,244 @@
+import os
+import sys
+import tempfile
+import time
+import types
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src'))
+
+# MPI communicator recording the sent messages,
+# recv returns the messages queued in inbox for (source, tag)
+class FakeComm:
+    def __init__(self):
+        self.sent = []
+        self.inbox = {}
+
+    def Get_rank(self):
+        return 0
+
+    def Get_size(self):
+        return 4
+
+    def send(self, obj, dest, tag):
+        self.sent.append((obj, dest, tag))
+
+    def recv(self, source, tag):
+        return self.inbox[(source, tag)].pop(0)
+
+# the coordinator runs without mpi4py
+fake_mpi4py = types.ModuleType('mpi4py')
+fake_mpi4py.MPI = types.SimpleNamespace(COMM_WORLD=FakeComm())
+sys.modules['mpi4py'] = fake_mpi4py
+
+from coordinator import Coordinator
+from partition_tree import NodeReason, NodeStatus, ParallelTree
+from task_delta import DeltaTaskLoader
+from test_task_delta import BASE, DELTA, TASK
+
+class FakePartitioner:
+    def __init__(self):
+        self.messages = []
+        self.result = None
+
+    def check_running(self):
+        return True
+
+    def is_receive_done(self):
+        return False
+
+    def send_message(self, msg: str):
+        self.messages.append(msg)
+
+    def set_result(self, result: str):
+        self.result = result
+
+# task buffer recording the received and released tasks
+class FakeTaskBuffer:
+    def __init__(self):
+        self.received = []
+        self.released = []
+
+    def receive_task(self, task_tag: str, offset: int, length: int):
+        self.received.append((task_tag, offset, length))
+
+    def get_task_path(self, task_tag: str):
+        return None
+
+    def release_task(self, task_tag: str):
+        self.released.append(task_tag)
+
+# solver process that has answered
+class FakeSolverProcess:
+    def __init__(self, out_data: str):
+        self.out_data = out_data
+
+    def poll(self):
+        return 0
+
+    def communicate(self):
+        return self.out_data, ''
+
+    def terminate(self):
+        pass
+
+class CoordinatorTestCase(unittest.TestCase):
+    def setUp(self):
+        self.comm = FakeComm()
+        fake_mpi4py.MPI.COMM_WORLD = self.comm
+        self.temp_dir = tempfile.TemporaryDirectory()
+        # the coordinator is built without its command line
+        c = Coordinator.__new__(Coordinator)
+        c.rank = 0
+        c.leader_rank = 3
+        c.solving_round = 0
+        c.available_cores = 4
+        c.time_limit = 1200.0
+        c.get_model_flag = False
+        c.coordinator_start_time = time.time()
+        c.coord_temp_folder_path = self.temp_dir.name
+        c.solving_folder_path = os.path.join(self.temp_dir.name, 'tasks')
+        os.makedirs(c.solving_folder_path)
+        c.result = NodeStatus.unsolved
+        c.tree = ParallelTree(time.time())
+        c.partitioner = FakePartitioner()
+        c.task_buffer = FakeTaskBuffer()
+        c.delta_tasks = False
+        c.delta_loader = DeltaTaskLoader()
+        c.subtree_donation = False
+        c.subtree_exports = {}
+        c.import_subtree_path = None
+        c.split_node = None
+        self.coord = c
+
+    def tearDown(self):
+        self.temp_dir.cleanup()
+
+    # the partitioner makes the nodes of the tree 0 -> (1, 2), 1 -> (3, 4)
+    def make_tree(self):
+        for msg in ['1 0 -1', '1 1 0', '1 2 0', '1 3 1', '1 4 1']:
+            self.coord.process_partitioner_msg(msg)
+        return self.coord.tree.pid2node
+
+    def write_task_file(self, name: str, content: str):
+        with open(os.path.join(self.coord.solving_folder_path, name), 'w') as file:
+            file.write(content)
+
+    # releasing a task twice is harmless (TaskBuffer.release_task)
+    def released(self):
+        return sorted(set(self.coord.task_buffer.released))
+
+class TaskReleaseTest(CoordinatorTestCase):
+    def test_receive_task(self):
+        self.make_tree()
+        self.coord.process_partitioner_msg('6 3 128 17')
+        self.assertEqual(self.coord.task_buffer.received, [('3', 128, 17)])
+
+    def test_partitioner_unsat_node(self):
+        self.make_tree()
+        self.coord.process_partitioner_msg('2 5 2')
+        self.assertEqual(self.released(), ['5'])
+
+    def test_child_of_unsat_node(self):
+        nodes = self.make_tree()
+        self.coord.tree.node_solved_unsat(nodes[2], NodeReason.partitioner)
+        self.coord.process_partitioner_msg('1 5 2')
+        self.assertTrue(self.coord.tree.pid2node[5].status.is_unsat())
+        # with its unsat parent
+        self.assertEqual(self.released(), ['2', '5'])
+
+    def test_solved_node(self):
+        nodes = self.make_tree()
+        self.coord.tree.assign_node(nodes[3], FakeSolverProcess('unsat\n'))
+        self.assertFalse(self.coord.check_solving_status(nodes[3]))
+        self.assertEqual(self.released(), ['3'])
+        self.assertEqual(self.coord.partitioner.messages[-1].split()[: 2], ['0', '3'])
+
+    def test_unsat_subtree_and_ancestors(self):
+        nodes = self.make_tree()
+        self.coord.tree.assign_node(nodes[4], FakeSolverProcess('unsat\n'))
+        self.coord.check_solving_status(nodes[4])
+        # node 1 becomes unsat by its children, its subtree and itself end
+        self.coord.tree.assign_node(nodes[3], FakeSolverProcess('unsat\n'))
+        self.coord.check_solving_status(nodes[3])
+        self.assertTrue(nodes[1].status.is_unsat())
+        self.assertEqual(self.released(), ['1', '3', '4'])
+
+    def test_terminated_node(self):
+        nodes = self.make_tree()
+        self.coord.tree.assign_node(nodes[2], FakeSolverProcess(''))
+        self.coord.terminate_node(nodes[2])
+        self.assertEqual(self.released(), ['2'])
+        self.assertEqual(self.coord.partitioner.messages[-1].split()[: 2], ['1', '2'])
+
+    def test_split_node(self):
+        nodes = self.make_tree()
+        self.write_task_file('task-2.smt2', '(check-sat)\n')
+        # the task of the split node is kept until it is sent
+        self.coord.split_node = nodes[2]
+        self.coord.set_node_split(nodes[2], 1)
+        self.assertNotIn('2', self.released())
+        self.coord.send_split_node_to_coordinator(1)
+        self.assertIn('2', self.released())
+        self.assertEqual(self.coord.split_node, None)
+
+    # tasks are files, ended nodes have nothing to release
+    def test_no_task_buffer(self):
+        nodes = self.make_tree()
+        self.coord.task_buffer = None
+        self.coord.process_partitioner_msg('2 5 2')
+        self.coord.terminate_node(nodes[3])
+
+# a split node is sent as (task, None, subtree) or, in delta mode, as (task base, delta, subtree)
+class SplitNodeProtocolTest(CoordinatorTestCase):
+    def received_task(self):
+        with open(os.path.join(self.coord.coord_temp_folder_path, 'tasks', 'round-0', 'task-root.smt2')) as file:
+            return file.read()
+
+    def test_send_task(self):
+        nodes = self.make_tree()
+        self.write_task_file('task-2.smt2', TASK)
+        self.coord.split_node = nodes[2]
+        self.coord.send_split_node_to_coordinator(1)
+        self.assertEqual(self.comm.sent, [((TASK.encode(), None, None), 1, 2)])
+
+    def test_send_delta_task(self):
+        nodes = self.make_tree()
+        self.coord.delta_tasks = True
+        self.write_task_file('task-base.smt2', BASE)
+        self.write_task_file('task-2.delta', DELTA)
+        self.coord.split_node = nodes[2]
+        self.coord.send_split_node_to_coordinator(1)
+        self.assertEqual(self.comm.sent, [((BASE.encode(), DELTA.encode(), None), 1, 2)])
+        # the task is not materialized by the sender
+        self.assertFalse(os.path.exists(os.path.join(self.coord.solving_folder_path, 'task-2.smt2')))
+
+    def test_send_root_task(self):
+        self.write_task_file('task-root.smt2', BASE)
+        self.coord.send_root_task_to_coordinator(1)
+        self.assertEqual(self.comm.sent, [((BASE.encode(), None, None), 1, 2)])
+
+    def test_receive_task(self):
+        self.comm.inbox[(1, 2)] = [(TASK.encode(), None, b'subtree')]
+        self.coord.receive_node_from_coordinator(1)
+        self.assertEqual(self.received_task(), TASK)
+        with open(self.coord.import_subtree_path, 'rb') as file:
+            self.assertEqual(file.read(), b'subtree')
+
+    def test_receive_delta_task(self):
+        self.comm.inbox[(1, 2)] = [(BASE.encode(), DELTA.encode(), None)]
+        self.coord.receive_node_from_coordinator(1)
+        self.assertEqual(self.received_task(), TASK)
+        self.assertEqual(self.coord.import_subtree_path, None)
+
+    def test_materialize_task(self):
+        self.coord.delta_tasks = True
+        self.write_task_file('task-base.smt2', BASE)
+        self.write_task_file('task-2.delta', DELTA)
+        path = self.coord.materialize_task('2')
+        self.assertEqual(path, os.path.join(self.coord.solving_folder_path, 'task-2.smt2'))
+        with open(path) as file:
+            self.assertEqual(file.read(), TASK)
+
+if __name__ == '__main__':
+    unittest.main()
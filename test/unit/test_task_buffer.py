@@ -0,0 +1,83 @@
+import os
+import struct
+import sys
+import unittest
+from multiprocessing import shared_memory
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src'))
+from task_buffer import TaskBuffer
+
+# writes a task to the buffer as the partitioner does (task_buffer.cpp),
+# the task is at offset, the head is moved after it
+def write_task(buffer: TaskBuffer, offset: int, content: bytes):
+    pos = TaskBuffer.header_size + offset % buffer.capacity
+    buffer.shm.buf[pos: pos + len(content)] = content
+    struct.pack_into('<Q', buffer.shm.buf, 8, offset + len(content))
+
+def read_header(buffer: TaskBuffer):
+    return struct.unpack_from('<QQQ', buffer.shm.buf, 0)
+
+class TaskBufferTest(unittest.TestCase):
+    def setUp(self):
+        self.buffer = TaskBuffer(f'ariparti-test-{os.getpid()}', 64)
+
+    def tearDown(self):
+        self.buffer.close()
+
+    def read_task(self, task_tag: str):
+        with open(self.buffer.get_task_path(task_tag), 'rb') as file:
+            return file.read()
+
+    def test_header(self):
+        self.assertEqual(read_header(self.buffer), (64, 0, 0))
+
+    def test_receive_task(self):
+        write_task(self.buffer, 0, b'(assert (> x 0))\n')
+        self.buffer.receive_task('1', 0, 17)
+        self.assertEqual(self.read_task('1'), b'(assert (> x 0))\n')
+        # the space of the task is released
+        self.assertEqual(read_header(self.buffer), (64, 17, 17))
+        self.assertEqual(self.buffer.get_task_fds('1'), (self.buffer.task_fds['1'], ))
+
+    def test_skipped_end(self):
+        write_task(self.buffer, 0, b'a' * 40)
+        self.buffer.receive_task('1', 0, 40)
+        # the second task does not fit in the end of the data area, it is written at its start
+        write_task(self.buffer, 64, b'b' * 30)
+        self.buffer.receive_task('2', 64, 30)
+        self.assertEqual(self.read_task('1'), b'a' * 40)
+        self.assertEqual(self.read_task('2'), b'b' * 30)
+        self.assertEqual(read_header(self.buffer), (64, 94, 94))
+
+    def test_unknown_task(self):
+        self.assertEqual(self.buffer.get_task_path('1'), None)
+        self.assertEqual(self.buffer.get_task_fds('1'), ())
+        self.buffer.release_task('1')
+
+    def test_release_task(self):
+        write_task(self.buffer, 0, b'(check-sat)\n')
+        self.buffer.receive_task('1', 0, 12)
+        fd = self.buffer.task_fds['1']
+        self.buffer.release_task('1')
+        self.assertEqual(self.buffer.get_task_path('1'), None)
+        with self.assertRaises(OSError):
+            os.fstat(fd)
+        # releasing a task twice is harmless
+        self.buffer.release_task('1')
+
+    def test_close(self):
+        write_task(self.buffer, 0, b'(check-sat)\n')
+        self.buffer.receive_task('1', 0, 12)
+        fd = self.buffer.task_fds['1']
+        name = self.buffer.name
+        self.buffer.close()
+        with self.assertRaises(OSError):
+            os.fstat(fd)
+        with self.assertRaises(FileNotFoundError):
+            shared_memory.SharedMemory(name=name)
+        # the buffer may be closed again, its shared memory object is already unlinked
+        self.buffer = TaskBuffer(f'ariparti-test-{os.getpid()}', 64)
+        shared_memory.SharedMemory(name=self.buffer.name).unlink()
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,118 @@
+import os
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'src'))
+from task_delta import DeltaTaskError, DeltaTaskLoader, parse_keep, parse_script
+
+BASE = '''; task-base
+(set-info :status unknown)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun |y (1)| () Int)
+(assert
+ (> x 0))
+(assert
+ (< |y (1)| 3)) ; comment with a parenthesis (
+(assert
+ (= x 1))
+(assert
+ (distinct x 2))
+(check-sat)
+'''
+
+DELTA = '''; base task-base.smt2
+; keep 0 2-3
+; task-3
+(set-info :status unknown)
+(set-logic QF_LIA)
+(declare-fun w () Int)
+(assert
+ (> w |y (1)|))
+(check-sat)
+(get-model)
+'''
+
+# the task of DELTA, as written by the partitioner with -materialize
+TASK = '''(set-info :status unknown)
+(set-logic QF_LIA)
+(declare-fun x () Int)
+(declare-fun |y (1)| () Int)
+(declare-fun w () Int)
+(assert
+ (> x 0))
+(assert
+ (= x 1))
+(assert
+ (distinct x 2))
+(assert
+ (> w |y (1)|))
+(check-sat)
+(get-model)
+'''
+
+class ParseTest(unittest.TestCase):
+    def test_parse_script(self):
+        s = parse_script(BASE)
+        self.assertEqual(len(s.header), 4)
+        self.assertEqual(s.header[3], '(declare-fun |y (1)| () Int)')
+        self.assertEqual(s.asserts[1], '(assert\n (< |y (1)| 3))')
+        self.assertEqual(len(s.asserts), 4)
+        self.assertFalse(s.get_model)
+        self.assertTrue(parse_script(DELTA).get_model)
+
+    def test_parse_string(self):
+        s = parse_script('(set-info :source "a ""quoted"" (string")\n(check-sat)\n')
+        self.assertEqual(s.header, ['(set-info :source "a ""quoted"" (string")'])
+
+    def test_malformed_script(self):
+        self.assertEqual(parse_script('(assert (> x 0)'), None)
+        self.assertEqual(parse_script('(assert (> x 0)))'), None)
+        self.assertEqual(parse_script('(assert |x)'), None)
+
+    def test_parse_keep(self):
+        self.assertEqual(parse_keep('0 2-3', 5), [True, False, True, True, False])
+        self.assertEqual(parse_keep('', 2), [False, False])
+        self.assertEqual(parse_keep('1-5', 5), None)
+        self.assertEqual(parse_keep('3-2', 5), None)
+        self.assertEqual(parse_keep('a', 5), None)
+
+class DeltaTaskLoaderTest(unittest.TestCase):
+    def setUp(self):
+        self.loader = DeltaTaskLoader()
+        self.loader.set_base('task-base.smt2', BASE)
+
+    def test_base_name(self):
+        self.assertEqual(DeltaTaskLoader.get_base_name(DELTA), 'task-base.smt2')
+        with self.assertRaises(DeltaTaskError):
+            DeltaTaskLoader.get_base_name('; keep 0\n(check-sat)\n')
+
+    def test_splice(self):
+        self.assertEqual(self.loader.splice(DELTA), TASK)
+
+    def test_invalid_delta(self):
+        with self.assertRaises(DeltaTaskError):
+            self.loader.splice('; base task-base.smt2\n(check-sat)\n')
+        with self.assertRaises(DeltaTaskError):
+            self.loader.splice('; base task-base.smt2\n; keep 0-4\n(check-sat)\n')
+        with self.assertRaises(DeltaTaskError):
+            self.loader.splice('; base task-base.smt2\n; keep 0\n(assert\n')
+        with self.assertRaises(DeltaTaskError):
+            self.loader.set_base('task-base.smt2', '(assert')
+
+    def test_materialize(self):
+        with tempfile.TemporaryDirectory() as task_dir:
+            with open(os.path.join(task_dir, 'task-base.smt2'), 'w') as file:
+                file.write(BASE)
+            with open(os.path.join(task_dir, 'task-3.delta'), 'w') as file:
+                file.write(DELTA)
+            loader = DeltaTaskLoader()
+            self.assertEqual(loader.materialize(os.path.join(task_dir, 'task-3.delta')), TASK)
+            # the base is parsed once for all the deltas of the directory
+            base = loader.base
+            self.assertEqual(loader.materialize(os.path.join(task_dir, 'task-3.delta')), TASK)
+            self.assertIs(loader.base, base)
+
+if __name__ == '__main__':
+    unittest.main()